@@ -0,0 +1,39 @@
+#ifndef __incl_allocations__
+#define __incl_allocations__
+
+#include <cstdlib>
+#include <new>
+
+//Counts heap allocations. With glibc every allocation, Eigen's included,
+//goes through malloc; elsewhere only operator new is seen. Replaces the
+//allocator for the whole program, so include it from one file only.
+static long g_allocations = 0;
+
+#ifdef __GLIBC__
+extern "C" void* __libc_malloc(size_t size);
+
+extern "C" void*
+malloc(size_t size)
+{
+    ++g_allocations;
+    return __libc_malloc(size);
+}
+#else
+void*
+operator new(size_t size)
+{
+    ++g_allocations;
+    void* p = std::malloc(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+#endif
+
+#endif
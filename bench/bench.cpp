@@ -0,0 +1,312 @@
+//Micro-benchmarks for the solver's building blocks.
+//usage: bench [--json] [--quick] [--solver pinv|dls|sdls|fabrik|ccd|hybrid] [--max-joints n]
+//
+//Times forward kinematics, each joint type's getTransform and getJacobian,
+//the minimum-norm step through an SVD of the Jacobian and through its 3x3
+//normal matrix, one ChainSolver::approachPoint step and a full
+//ChainSolver::solve (the Root::update loop) for chains of 1, 2, 4 .. 256
+//joints and several joint mixes. Each measurement is calibrated to a batch
+//of at least a millisecond, then repeated; the min, median, mean and
+//standard deviation of the time per operation are reported with the heap
+//allocations per operation, as CSV or as JSON.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "allocations.h"
+#include "arm.h"
+#include "benchutil.h"
+
+struct Options
+{
+    bool json;
+    int samples;
+    double minBatchSeconds;
+    int maxJoints;
+    SolverMode mode;
+};
+
+struct Measurement
+{
+    std::string name;
+    std::string mix;
+    int joints;
+    int dof;
+    long batch;
+    double min, median, mean, stddev; //Nanoseconds per operation
+    double allocations; //Per operation
+};
+
+static volatile float g_sink;
+
+static double
+secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//Runs op in batches large enough to time reliably and summarizes the samples
+template <class Op>
+static Measurement
+measure(const Options& options, Op op)
+{
+    Measurement m;
+    long batch = 1;
+    for (;;) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (long i = 0; i < batch; ++i)
+            op();
+        if (secondsSince(start) >= options.minBatchSeconds || batch >= (1L << 30))
+            break;
+        batch *= 2;
+    }
+
+    std::vector<double> times(options.samples);
+    long allocations = g_allocations;
+    for (int s = 0; s < options.samples; ++s) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (long i = 0; i < batch; ++i)
+            op();
+        times[s] = secondsSince(start) * 1e9 / batch;
+    }
+    allocations = g_allocations - allocations;
+
+    std::sort(times.begin(), times.end());
+    double sum = 0;
+    for (int s = 0; s < options.samples; ++s)
+        sum += times[s];
+    double mean = sum / options.samples;
+    double variance = 0;
+    for (int s = 0; s < options.samples; ++s)
+        variance += (times[s] - mean) * (times[s] - mean);
+
+    m.batch = batch;
+    m.min = times.front();
+    m.median = times[options.samples / 2];
+    m.mean = mean;
+    m.stddev = options.samples > 1 ? std::sqrt(variance / (options.samples - 1)) : 0;
+    m.allocations = allocations / (double)(batch * options.samples);
+    return m;
+}
+
+static void
+report(const Options& options, const Measurement& m, bool first)
+{
+    if (options.json) {
+        printf("%s  {\"benchmark\": \"%s\", \"mix\": \"%s\", \"joints\": %d, \"dof\": %d, "
+               "\"batch\": %ld, \"min_ns\": %.1f, \"median_ns\": %.1f, \"mean_ns\": %.1f, "
+               "\"stddev_ns\": %.1f, \"allocations\": %.3f}",
+               first ? "" : ",\n", m.name.c_str(), m.mix.c_str(), m.joints, m.dof, m.batch,
+               m.min, m.median, m.mean, m.stddev, m.allocations);
+    } else {
+        printf("%s,%s,%d,%d,%ld,%.1f,%.1f,%.1f,%.1f,%.3f\n", m.name.c_str(), m.mix.c_str(),
+               m.joints, m.dof, m.batch, m.min, m.median, m.mean, m.stddev, m.allocations);
+    }
+}
+
+template <class Kind>
+static void
+benchJoint(const Options& options, const char* name, const float* state, bool& first)
+{
+    Eigen::Vector3f point(0.3f, -0.2f, 0.5f);
+
+    Measurement m = measure(options, [&]() {
+        g_sink = Kind::getTransform(state)(0, 0);
+    });
+    m.name = std::string(name) + "_transform";
+    m.mix = name;
+    m.joints = 1;
+    m.dof = Kind::DOF;
+    report(options, m, first);
+    first = false;
+
+    m = measure(options, [&]() {
+        g_sink = Kind::getJacobian(state, point)(0, 0);
+    });
+    m.name = std::string(name) + "_jacobian";
+    m.mix = name;
+    m.joints = 1;
+    m.dof = Kind::DOF;
+    report(options, m, false);
+}
+
+static void
+benchChain(const Options& options, const char* mix, int n, bool& first)
+{
+    Arm* arm = makeArm(mix, n);
+    Chain chain(arm->getChain());
+    ChainSolver solver(&chain, arm->getSolver());
+    solver.setMode(options.mode);
+    std::vector<float> start(chain.getParams(), chain.getParams() + chain.getNumOfConstraints());
+
+    std::srand(1);
+    std::vector<Eigen::Vector3f> targets(16);
+    for (size_t i = 0; i < targets.size(); ++i)
+        targets[i] = Eigen::Vector3f::Random() * 1.5f;
+    size_t next = 0;
+
+    Measurement m[7];
+
+    //Forward kinematics from scratch: alternating between two poses drops
+    //every cached frame, the chain's and a fixed-size kernel's
+    std::vector<float> moved(start);
+    for (size_t i = 0; i < moved.size(); ++i)
+        moved[i] += 0.01f;
+    bool flip = false;
+    m[0] = measure(options, [&]() {
+        chain.setParams(flip ? &moved[0] : &start[0]);
+        flip = !flip;
+        g_sink = solver.getEndEffector()(0);
+    });
+    m[0].name = "end_effector";
+
+    Eigen::MatrixXf jacobian(3, chain.getNumOfConstraints());
+    m[1] = measure(options, [&]() {
+        chain.invalidate(0);
+        g_sink = chain.getJacobian(jacobian)(0);
+    });
+    m[1].name = "jacobian";
+
+    //What a ChainSolver with a Jacobian refresh above 1 does between builds
+    Eigen::MatrixXf refined = jacobian;
+    Eigen::VectorXf observed = Eigen::VectorXf::Constant(chain.getNumOfConstraints(), 0.01f);
+    m[2] = measure(options, [&]() {
+        updateBroyden(refined, Eigen::Vector3f(0.01f, 0.0f, -0.01f), observed.data());
+        g_sink = refined(0, 0);
+    });
+    m[2].name = "jacobian_broyden";
+
+    //The two ways of taking the pseudoinverse step, on the same Jacobian
+    Eigen::Vector3f deltaP(0.1f, -0.2f, 0.05f);
+    Eigen::VectorXf step(chain.getNumOfConstraints());
+    Eigen::JacobiSVD<Eigen::MatrixXf> svd(3, chain.getNumOfConstraints(),
+                                          Eigen::ComputeThinU | Eigen::ComputeThinV);
+    m[3] = measure(options, [&]() {
+        svd.compute(jacobian);
+        solvePseudoInverse(svd, deltaP, step);
+        g_sink = step(0);
+    });
+    m[3].name = "pinv_svd";
+
+    m[4] = measure(options, [&]() {
+        solveMinimumNorm(jacobian, deltaP, step);
+        g_sink = step(0);
+    });
+    m[4].name = "pinv_normal";
+
+    //Both start from the same pose every time, toward a rotating set of goals
+    m[5] = measure(options, [&]() {
+        chain.setParams(&start[0]);
+        solver.approachPoint(targets[next++ % targets.size()], 1);
+    });
+    m[5].name = "approach_point";
+
+    //Iteration counts vary a lot between goals, so one operation solves
+    //for every goal and is then scaled to a single solve
+    float damping = solver.getDamping();
+    m[6] = measure(options, [&]() {
+        for (size_t i = 0; i < targets.size(); ++i) {
+            chain.setParams(&start[0]);
+            solver.setDamping(damping);
+            g_sink = solver.solve(targets[i]).error;
+        }
+    });
+    m[6].name = "solve";
+    m[6].min /= targets.size();
+    m[6].median /= targets.size();
+    m[6].mean /= targets.size();
+    m[6].stddev /= targets.size();
+    m[6].allocations /= targets.size();
+
+    for (int i = 0; i < 7; ++i) {
+        m[i].mix = mix;
+        m[i].joints = n;
+        m[i].dof = chain.getNumOfConstraints();
+        report(options, m[i], first && i == 0);
+    }
+    first = false;
+
+    delete arm;
+}
+
+static int
+usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--json] [--quick] [--solver pinv|dls|sdls|fabrik|ccd|hybrid] "
+                    "[--max-joints n]\n", program);
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    options.json = false;
+    options.samples = 15;
+    options.minBatchSeconds = 0.001;
+    options.maxJoints = 256;
+    options.mode = PSEUDOINVERSE_SOLVER;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--json")) {
+            options.json = true;
+        } else if (!strcmp(argv[i], "--quick")) {
+            options.samples = 5;
+            options.minBatchSeconds = 0.0002;
+            options.maxJoints = 32;
+        } else if (!strcmp(argv[i], "--solver") && i + 1 < argc) {
+            ++i;
+            if (!strcmp(argv[i], "dls"))
+                options.mode = DLS_SOLVER;
+            else if (!strcmp(argv[i], "sdls"))
+                options.mode = SDLS_SOLVER;
+            else if (!strcmp(argv[i], "fabrik"))
+                options.mode = FABRIK_SOLVER;
+            else if (!strcmp(argv[i], "ccd"))
+                options.mode = CCD_SOLVER;
+            else if (!strcmp(argv[i], "hybrid"))
+                options.mode = HYBRID_SOLVER;
+            else if (!strcmp(argv[i], "pinv"))
+                options.mode = PSEUDOINVERSE_SOLVER;
+            else
+                return usage(argv[0]);
+        } else if (!strcmp(argv[i], "--max-joints") && i + 1 < argc) {
+            options.maxJoints = std::max(1, std::atoi(argv[++i]));
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    if (options.json)
+        printf("[\n");
+    else
+        printf("benchmark,mix,joints,dof,batch,min_ns,median_ns,mean_ns,stddev_ns,allocations\n");
+
+    bool first = true;
+    float ball[] = { 0.4f, -0.7f, 0.2f };
+    float pin[] = { 0.6f };
+    float prism[] = { 0.3f };
+    float doublePin[] = { 0.6f, -0.3f };
+    benchJoint<BallJoint>(options, "ball", ball, first);
+    benchJoint<PinJoint>(options, "pin", pin, first);
+    benchJoint<PrismJoint>(options, "prism", prism, first);
+    benchJoint<DoublePinJoint>(options, "double_pin", doublePin, first);
+
+    //b = ball, n = pin, d = double pin, p = prismatic
+    const char* mixes[] = { "b", "n", "d", "bdbp" };
+    for (size_t i = 0; i < sizeof(mixes) / sizeof(mixes[0]); ++i) {
+        for (int n = 1; n <= options.maxJoints; n *= 2)
+            benchChain(options, mixes[i], n, first);
+    }
+
+    if (options.json)
+        printf("\n]\n");
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+#ifndef __incl_benchutil__
+#define __incl_benchutil__
+
+#include <cstring>
+
+#include "arm.h"
+
+//Helpers shared by the benchmark and check programs, each of which is a
+//single translation unit
+
+static Joint*
+makeJoint(char type, Body* inboard, Body* outboard)
+{
+    switch (type) {
+        case 'p':
+            return new PrismJoint(inboard, outboard);
+        case 'n':
+            return new PinJoint(inboard, outboard);
+        case 'd':
+            return new DoublePinJoint(inboard, outboard);
+        default:
+            return new BallJoint(inboard, outboard);
+    }
+}
+
+//Arm of n joints cycling through the types in mix, two units long in total
+static Arm*
+makeArm(const char* mix, int n)
+{
+    Arm* arm = new Arm();
+    Body* prev = NULL;
+    for (int i = 0; i < n; ++i) {
+        Body* b = new Body(2.0f / n);
+        arm->appendJoint(makeJoint(mix[i % std::strlen(mix)], prev, b));
+        prev = b;
+    }
+    return arm;
+}
+
+#endif
@@ -0,0 +1,82 @@
+//Throughput of LaneKernel against the scalar solver.
+//usage: lanes [targets] [joints]
+//Solves the same random targets with ChainSolver::solveBatch in DLS mode and
+//with solveBatchLanes at 4 and 8 lanes, and prints solves per second.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "arm.h"
+#include "lanekernel.h"
+
+static double
+secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void
+report(const char* name, double time, const std::vector<SolveResult>& results)
+{
+    int converged = 0;
+    long iterations = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        converged += results[i].converged;
+        iterations += results[i].iterations;
+    }
+    printf("%s,%.4f,%.0f,%d,%ld\n", name, time, results.size() / time, converged, iterations);
+}
+
+int main(int argc, char** argv)
+{
+    int numOfTargets = argc > 1 ? std::atoi(argv[1]) : 4000;
+    int numOfJoints = argc > 2 ? std::atoi(argv[2]) : 8;
+    if (numOfTargets < 1 || numOfJoints < 1) {
+        fprintf(stderr, "usage: %s [targets] [joints]\n", argv[0]);
+        return 1;
+    }
+
+    Arm arm;
+    Body* prev = NULL;
+    for (int i = 0; i < numOfJoints; ++i) {
+        Body* b = new Body(2.0f / numOfJoints);
+        Joint* j;
+        if (i % 2)
+            j = new DoublePinJoint(prev, b);
+        else
+            j = new BallJoint(prev, b);
+        arm.appendJoint(j);
+        prev = b;
+    }
+    arm.getSolver().setMode(DLS_SOLVER);
+
+    std::srand(1);
+    std::vector<Eigen::Vector3f> targets(numOfTargets);
+    for (int i = 0; i < numOfTargets; ++i)
+        targets[i] = Eigen::Vector3f::Random() * 1.5f;
+
+    const Chain& chain = arm.getChain();
+    std::vector<float> solutions(numOfTargets * chain.getNumOfConstraints());
+    std::vector<SolveResult> results(numOfTargets);
+    float lambda = arm.getSolver().getDamping();
+
+    printf("solver,seconds,solves_per_second,converged,iterations\n");
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    arm.solveBatch(&targets[0], numOfTargets, NULL, &solutions[0], &results[0]);
+    report("scalar", secondsSince(start), results);
+
+    start = std::chrono::steady_clock::now();
+    solveBatchLanes<4>(chain, chain.getParams(), &targets[0], numOfTargets, NULL, lambda,
+                       &solutions[0], &results[0]);
+    report("lanes4", secondsSince(start), results);
+
+    start = std::chrono::steady_clock::now();
+    solveBatchLanes<8>(chain, chain.getParams(), &targets[0], numOfTargets, NULL, lambda,
+                       &solutions[0], &results[0]);
+    report("lanes8", secondsSince(start), results);
+
+    return 0;
+}
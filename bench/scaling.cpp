@@ -0,0 +1,82 @@
+//Scaling benchmark for Arm::solveBatch on a ThreadPool.
+//usage: scaling [targets] [max threads] [joints]
+//Solves the same random targets serially and on pools of 1 .. max threads,
+//checks that every run produces the serial solutions, and prints the
+//speedup over the serial run.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "arm.h"
+#include "threadpool.h"
+
+static double
+secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    int numOfTargets = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int maxThreads = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    int numOfJoints = argc > 3 ? std::atoi(argv[3]) : 8;
+    if (numOfTargets < 1 || maxThreads < 1 || numOfJoints < 1) {
+        fprintf(stderr, "usage: %s [targets] [max threads] [joints]\n", argv[0]);
+        return 1;
+    }
+
+    //Alternating ball and double pin joints, long enough that the dynamic
+    //kernel is used and each solve does real work
+    Arm arm;
+    Body* prev = NULL;
+    for (int i = 0; i < numOfJoints; ++i) {
+        Body* b = new Body(2.0f / numOfJoints);
+        Joint* j;
+        if (i % 2)
+            j = new DoublePinJoint(prev, b);
+        else
+            j = new BallJoint(prev, b);
+        arm.appendJoint(j);
+        prev = b;
+    }
+    arm.getSolver().setMode(DLS_SOLVER);
+
+    std::srand(1);
+    std::vector<Eigen::Vector3f> targets(numOfTargets);
+    for (int i = 0; i < numOfTargets; ++i)
+        targets[i] = Eigen::Vector3f::Random() * 1.5f;
+
+    int n = arm.getChain().getNumOfConstraints();
+    std::vector<float> serial(numOfTargets * n);
+    std::vector<float> solutions(numOfTargets * n);
+    std::vector<SolveResult> results(numOfTargets);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    arm.solveBatch(&targets[0], numOfTargets, NULL, &serial[0], &results[0]);
+    double serialTime = secondsSince(start);
+
+    int converged = 0;
+    for (int i = 0; i < numOfTargets; ++i)
+        converged += results[i].converged;
+
+    printf("%d targets, %d joints (%s), %d converged\n", numOfTargets, numOfJoints,
+           arm.getSolver().getKernel()->getInstance().c_str(), converged);
+    printf("threads,seconds,speedup,matches_serial\n");
+    printf("serial,%.4f,1.00,yes\n", serialTime);
+
+    for (int threads = 1; threads <= maxThreads; ++threads) {
+        ThreadPool pool(threads);
+        start = std::chrono::steady_clock::now();
+        arm.solveBatch(&targets[0], numOfTargets, NULL, &solutions[0], &results[0], pool);
+        double time = secondsSince(start);
+
+        bool matches = !std::memcmp(&serial[0], &solutions[0], serial.size() * sizeof(float));
+        printf("%d,%.4f,%.2f,%s\n", threads, time, serialTime / time, matches ? "yes" : "no");
+    }
+
+    return 0;
+}
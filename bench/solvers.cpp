@@ -0,0 +1,125 @@
+//Per-frame cost of each solver mode.
+//usage: solvers [frames] [max joints]
+//
+//Arms of 4, 8 .. max joints (128 by default) of several joint mixes run two
+//scenarios. In "track" they follow a path, one PathTracker update per frame
+//with warm start on, as Root::update does. In "reach" every frame starts
+//from the rest pose toward a random goal, so each solve has far to go. For
+//every mode the converged frames, the iterations per frame and the mean and
+//worst microseconds per frame are printed as CSV.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "arm.h"
+#include "benchutil.h"
+#include "tracker.h"
+
+struct Mode
+{
+    const char* name;
+    SolverMode mode;
+    int refresh; //Steps per full Jacobian build
+};
+
+static void
+report(const char* scenario, const char* mix, int dof, int n, const Mode& mode, int frames,
+       int converged, long iterations, double total, double worst)
+{
+    printf("%s,%s,%d,%d,%s,%d,%d,%.2f,%.1f,%.1f\n", scenario, mix, n, dof, mode.name,
+           frames, converged, iterations / (double)frames, total * 1e6 / frames, worst * 1e6);
+}
+
+static void
+run(const char* mix, int n, const Mode& mode, int frames)
+{
+    Arm* arm = makeArm(mix, n);
+    Chain chain(arm->getChain());
+    ChainSolver solver(&chain, arm->getSolver());
+    solver.setMode(mode.mode);
+    solver.setJacobianRefresh(mode.refresh);
+    std::vector<float> rest(chain.getParams(), chain.getParams() + chain.getNumOfConstraints());
+
+    PathTracker tracker(&solver, true);
+    Path path;
+    path.setCoeff(0.2f, -0.1f);
+    path.setRad(1.2f, 0.9f);
+
+    int converged = 0;
+    long iterations = 0;
+    double total = 0;
+    double worst = 0;
+    for (int f = 0; f < frames; ++f) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        SolveResult result = tracker.update(path);
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        converged += result.converged;
+        iterations += result.iterations;
+        total += time;
+        worst = std::max(worst, time);
+    }
+    report("track", mix, chain.getNumOfConstraints(), n, mode, frames, converged, iterations,
+           total, worst);
+
+    std::srand(1);
+    converged = 0;
+    iterations = 0;
+    total = 0;
+    worst = 0;
+    for (int f = 0; f < frames; ++f) {
+        Eigen::Vector3f goal = Eigen::Vector3f::Random() * 1.2f;
+        chain.setParams(&rest[0]);
+        solver.setDamping(ChainSolver::DEFAULT_DAMPING);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        SolveResult result = solver.solve(goal);
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        converged += result.converged;
+        iterations += result.iterations;
+        total += time;
+        worst = std::max(worst, time);
+    }
+    report("reach", mix, chain.getNumOfConstraints(), n, mode, frames, converged, iterations,
+           total, worst);
+
+    delete arm;
+}
+
+int main(int argc, char** argv)
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 240;
+    int maxJoints = argc > 2 ? std::atoi(argv[2]) : 128;
+    if (frames < 1 || maxJoints < 1) {
+        fprintf(stderr, "usage: %s [frames] [max joints]\n", argv[0]);
+        return 1;
+    }
+
+    Mode modes[] = {
+        { "pinv", PSEUDOINVERSE_SOLVER, 1 },
+        { "pinv_broyden4", PSEUDOINVERSE_SOLVER, 4 },
+        { "dls", DLS_SOLVER, 1 },
+        { "dls_broyden4", DLS_SOLVER, 4 },
+        { "fabrik", FABRIK_SOLVER, 1 },
+        { "ccd", CCD_SOLVER, 1 },
+        { "hybrid", HYBRID_SOLVER, 1 }
+    };
+
+    //b = ball, n = pin, d = double pin, p = prismatic
+    const char* mixes[] = { "b", "d", "bdbp" };
+
+    printf("scenario,mix,joints,dof,solver,frames,converged,iterations_per_frame,mean_us,max_us\n");
+    for (size_t i = 0; i < sizeof(mixes) / sizeof(mixes[0]); ++i) {
+        for (int n = 4; n <= maxJoints; n *= 2) {
+            for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+                run(mixes[i], n, modes[m], frames);
+        }
+    }
+
+    return 0;
+}
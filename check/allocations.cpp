@@ -0,0 +1,140 @@
+//Fails if a warmed-up solve allocates.
+//usage: allocations
+//
+//For every SolverMode and a few joint mixes, runs approachPoint and solve
+//toward a fixed set of goals once to size every buffer, then again while
+//counting heap allocations, with and without telemetry attached. The same
+//is done for a Root scene per mode, whose updates carry telemetry. Any
+//allocation in the counted pass is reported and the exit status is 1.
+
+#include <cstdio>
+#include <vector>
+
+#include "allocations.h"
+#include "arm.h"
+#include "benchutil.h"
+#include "root.h"
+
+struct Mode
+{
+    const char* name;
+    const char* flag; //-solver argument
+    SolverMode mode;
+    int refresh; //Steps per full Jacobian build
+};
+
+static const Mode MODES[] = {
+    {"pinv", "pinv", PSEUDOINVERSE_SOLVER, 1},
+    {"pinv_broyden4", "pinv", PSEUDOINVERSE_SOLVER, 4},
+    {"dls", "dls", DLS_SOLVER, 1},
+    {"dls_broyden4", "dls", DLS_SOLVER, 4},
+    {"sdls", "sdls", SDLS_SOLVER, 1},
+    {"fabrik", "fabrik", FABRIK_SOLVER, 1},
+    {"ccd", "ccd", CCD_SOLVER, 1},
+    {"hybrid", "hybrid", HYBRID_SOLVER, 1},
+};
+
+static const char* MIXES[] = {"b", "p", "bdbp", "np", "bdnp"};
+
+static int g_failures = 0;
+
+static void
+expectNone(const char* what, const char* mix, int n, const Mode& mode, long allocations)
+{
+    if (allocations == 0)
+        return;
+    printf("FAIL %s %s x%d %s: %ld allocations\n", what, mix, n, mode.name, allocations);
+    ++g_failures;
+}
+
+//Every call starts from the same pose and damping, so the counted pass
+//repeats the warm-up exactly
+static long
+solveAll(Arm& arm, const std::vector<float>& start, float damping,
+         const std::vector<Eigen::Vector3f>& goals)
+{
+    ChainSolver& solver = arm.getSolver();
+    long allocations = g_allocations;
+    for (size_t i = 0; i < goals.size(); ++i) {
+        arm.setParams(&start[0]);
+        solver.setDamping(damping);
+        solver.approachPoint(goals[i], 1);
+        arm.setParams(&start[0]);
+        solver.setDamping(damping);
+        solver.solve(goals[i]);
+    }
+    return g_allocations - allocations;
+}
+
+static void
+checkSolver(const char* mix, int n, const Mode& mode, const std::vector<Eigen::Vector3f>& goals)
+{
+    Arm* arm = makeArm(mix, n);
+    ChainSolver& solver = arm->getSolver();
+    solver.setMode(mode.mode);
+    solver.setJacobianRefresh(mode.refresh);
+    const Chain& chain = arm->getChain();
+    std::vector<float> start(chain.getParams(), chain.getParams() + chain.getNumOfConstraints());
+    float damping = solver.getDamping();
+
+    solveAll(*arm, start, damping, goals);
+    expectNone("solve", mix, n, mode, solveAll(*arm, start, damping, goals));
+
+    SolveTelemetry telemetry;
+    solver.setTelemetry(&telemetry);
+    solveAll(*arm, start, damping, goals);
+    expectNone("telemetry solve", mix, n, mode, solveAll(*arm, start, damping, goals));
+
+    delete arm;
+}
+
+//The as4 loop in its default configuration: path tracking with telemetry,
+//one lap to warm up and one counted
+static void
+checkRoot(const Mode& mode)
+{
+    FILE* input = tmpfile();
+    if (!input) {
+        printf("FAIL root %s: unable to create the scene file\n", mode.name);
+        ++g_failures;
+        return;
+    }
+    fprintf(input, "-arm ba/.1 dp/.2 ba/.3 pm/.5\n-path 1 1\n-ell 1 1\n-solver %s\n-broyden %d\n",
+            mode.flag, mode.refresh);
+    rewind(input);
+
+    Root root;
+    root.init(0, NULL, input);
+    fclose(input);
+
+    const int lap = 240;
+    for (int i = 0; i < lap; ++i)
+        root.update();
+    long allocations = g_allocations;
+    for (int i = 0; i < lap; ++i)
+        root.update();
+    expectNone("root update", "bdbp", 4, mode, g_allocations - allocations);
+}
+
+int main(void)
+{
+    std::vector<Eigen::Vector3f> goals(16);
+    for (size_t i = 0; i < goals.size(); ++i)
+        goals[i] = Eigen::Vector3f::Random() * 1.5f;
+
+    int numOfModes = sizeof(MODES) / sizeof(MODES[0]);
+    for (int m = 0; m < numOfModes; ++m) {
+        for (size_t i = 0; i < sizeof(MIXES) / sizeof(MIXES[0]); ++i) {
+            for (int n = 1; n <= 16; n *= 4)
+                checkSolver(MIXES[i], n, MODES[m], goals);
+        }
+        checkRoot(MODES[m]);
+    }
+
+    if (g_failures) {
+        printf("allocations: %d failures\n", g_failures);
+        return 1;
+    }
+    printf("allocations: ok\n");
+    return 0;
+}
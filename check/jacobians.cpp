@@ -0,0 +1,131 @@
+//Compares the closed-form end effector Jacobian with central differences.
+//usage: jacobians
+//
+//For arms of each joint type and of the bdbp mix, Chain::getJacobian is
+//checked column by column against central differences of getEndEffector at
+//random poses, and with every ball joint at the zero rotation, just off it
+//and just short of a half turn.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "arm.h"
+#include "benchutil.h"
+
+#define STEP 1e-3f
+#define TOLERANCE 2e-3f //Absolute, on an arm two units long
+
+enum BallState
+{
+    RANDOM_BALLS,
+    ZERO_BALLS,
+    NEAR_ZERO_BALLS,
+    NEAR_PI_BALLS
+};
+
+static const char* BALL_STATES[] = {"random", "zero", "near zero", "near pi"};
+
+static int g_failures = 0;
+
+static float
+randomIn(float low, float high)
+{
+    return low + (high - low) * std::rand() / (float)RAND_MAX;
+}
+
+static void
+makePose(const Chain& chain, BallState balls, std::vector<float>& params)
+{
+    params.resize(chain.getNumOfConstraints());
+    for (int i = 0; i < chain.getNumOfJoints(); ++i) {
+        float* state = &params[chain.getOffset(i)];
+        switch (chain.getType(i)) {
+            case BALL_JOINT: {
+                Eigen::Vector3f axis(randomIn(-1, 1), randomIn(-1, 1), randomIn(-1, 1));
+                axis.normalize();
+                float angle = randomIn(0.1f, 3.0f);
+                if (balls == ZERO_BALLS)
+                    angle = 0;
+                else if (balls == NEAR_ZERO_BALLS)
+                    angle = 1e-4f;
+                else if (balls == NEAR_PI_BALLS)
+                    angle = M_PI - 1e-2f;
+                Eigen::Map<Eigen::Vector3f> expMap(state);
+                expMap = axis * angle;
+                break;
+            }
+            case PRISM_JOINT:
+                //Away from the lower limit, which only changeConstraint enforces
+                state[0] = randomIn(0.1f, 1.0f);
+                break;
+            case PIN_JOINT:
+                state[0] = randomIn(-3.0f, 3.0f);
+                break;
+            case DOUBLE_PIN_JOINT:
+                state[0] = randomIn(-3.0f, 3.0f);
+                state[1] = randomIn(-1.5f, 1.5f);
+                break;
+        }
+    }
+}
+
+static void
+checkPose(const char* mix, Chain& chain, BallState balls)
+{
+    std::vector<float> params;
+    makePose(chain, balls, params);
+    chain.setParams(&params[0]);
+    Eigen::MatrixXf jacobian(3, chain.getNumOfConstraints());
+    chain.getJacobian(jacobian);
+
+    std::vector<float> moved(params);
+    for (int j = 0; j < chain.getNumOfConstraints(); ++j) {
+        moved[j] = params[j] + STEP;
+        chain.setParams(&moved[0]);
+        Eigen::Vector3f ahead = chain.getEndEffector();
+        moved[j] = params[j] - STEP;
+        chain.setParams(&moved[0]);
+        Eigen::Vector3f behind = chain.getEndEffector();
+        moved[j] = params[j];
+
+        Eigen::Vector3f column = (ahead - behind) / (2 * STEP);
+        float error = (jacobian.col(j) - column).norm();
+        if (error > TOLERANCE) {
+            printf("FAIL %s, %s balls, column %d: closed form (%g %g %g), differences (%g %g %g)\n",
+                   mix, BALL_STATES[balls], j, jacobian(0, j), jacobian(1, j), jacobian(2, j),
+                   column(0), column(1), column(2));
+            ++g_failures;
+        }
+    }
+}
+
+static void
+checkArm(const char* mix, int n)
+{
+    Arm* arm = makeArm(mix, n);
+    Chain chain(arm->getChain());
+    for (int trial = 0; trial < 8; ++trial) {
+        for (int balls = RANDOM_BALLS; balls <= NEAR_PI_BALLS; ++balls)
+            checkPose(mix, chain, (BallState)balls);
+    }
+    delete arm;
+}
+
+int main(void)
+{
+    std::srand(1);
+    const char* mixes[] = {"b", "p", "n", "d", "bdbp"};
+    for (size_t i = 0; i < sizeof(mixes) / sizeof(mixes[0]); ++i) {
+        checkArm(mixes[i], 1);
+        checkArm(mixes[i], 4);
+    }
+
+    if (g_failures) {
+        printf("jacobians: %d failures\n", g_failures);
+        return 1;
+    }
+    printf("jacobians: ok\n");
+    return 0;
+}
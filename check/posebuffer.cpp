@@ -0,0 +1,82 @@
+//Stress test of PoseBuffer with one writer and one reader thread.
+//usage: posebuffer [frames]
+//
+//The writer publishes frames numbered 1 .. frames, filling every parameter
+//of frame k with k and every previous parameter with k - 1. The reader keeps
+//reading and fails on a snapshot whose values disagree with its frame
+//number, which a slot shared with the writer would show, on a frame older
+//than one it already saw, or if it never sees the last one.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "posebuffer.h"
+
+static const int PARAMS = 64;
+
+int main(int argc, char** argv)
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 200000;
+    if (frames < 1) {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+        return 1;
+    }
+
+    PoseBuffer buffer;
+    //Passing each slot through both sides once sizes all three before the
+    //threads start
+    for (int i = 0; i < 3; ++i) {
+        PoseSnapshot& slot = buffer.edit();
+        slot.params.assign(PARAMS, 0);
+        slot.previousParams.assign(PARAMS, -1);
+        slot.frame = 0;
+        buffer.publish();
+        buffer.read();
+    }
+
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+        for (int k = 1; k <= frames; ++k) {
+            PoseSnapshot& slot = buffer.edit();
+            slot.frame = k;
+            for (int i = 0; i < PARAMS; ++i) {
+                slot.params[i] = k;
+                slot.previousParams[i] = k - 1;
+            }
+            buffer.publish();
+        }
+        done.store(true);
+    });
+
+    long reads = 0, torn = 0, backwards = 0;
+    int last = 0;
+    while (true) {
+        //Loaded before the read, so the read after the writer finishes sees
+        //the last frame
+        bool finished = done.load();
+        const PoseSnapshot& pose = buffer.read();
+        for (int i = 0; i < PARAMS; ++i) {
+            if (pose.params[i] != pose.frame || pose.previousParams[i] != pose.frame - 1) {
+                ++torn;
+                break;
+            }
+        }
+        if (pose.frame < last)
+            ++backwards;
+        last = pose.frame;
+        ++reads;
+        if (finished)
+            break;
+    }
+    writer.join();
+
+    if (torn || backwards || last != frames) {
+        printf("posebuffer: FAIL, %ld torn and %ld out of order snapshots in %ld reads, "
+               "last frame %d of %d\n", torn, backwards, reads, last, frames);
+        return 1;
+    }
+    printf("posebuffer: ok, %d frames, %ld reads\n", frames, reads);
+    return 0;
+}
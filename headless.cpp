@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include "src/root.h"
+
+//Runs the same scene and update loop as as4 without a window: update() is
+//called back to back instead of at the viewer's 24 Hz, and a summary of the
+//solves is printed at the end.
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "usage: %s <file> [updates]\n", argv[0]);
+        exit(1);
+    }
+
+    //One full lap of the path by default, at 1.5 degrees per update
+    int numOfUpdates = argc == 3 ? std::atoi(argv[2]) : 240;
+    if (numOfUpdates < 1)
+    {
+        fprintf(stderr, "error! updates must be positive.\n");
+        exit(1);
+    }
+
+    FILE* input = fopen(argv[1], "r");
+
+    if (!input)
+    {
+        fprintf(stderr, "error! unable to open file <%s>.\n", argv[1]);
+        exit(1);
+    }
+
+    Root root;
+    root.init(argc, argv, input);
+    fclose(input);
+    root.getArm()->print();
+
+    int converged = 0;
+    int exhausted = 0;
+    long iterations = 0;
+    float maxError = 0;
+    double sumError = 0;
+    long halvings = 0;
+    long rejectedSteps = 0;
+    long fkEvaluations = 0;
+    double fkSeconds = 0, jacobianSeconds = 0, stepSeconds = 0;
+    double slowestSeconds = 0;
+    int slowestUpdate = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numOfUpdates; ++i) {
+        SolveResult result = root.update();
+        converged += result.converged;
+        exhausted += result.exhausted;
+        iterations += result.iterations;
+        maxError = std::max(maxError, result.error);
+        sumError += result.error;
+
+        const SolveTelemetry& telemetry = root.getTelemetry();
+        halvings += telemetry.halvings;
+        rejectedSteps += telemetry.rejectedSteps;
+        fkEvaluations += telemetry.fkEvaluations;
+        fkSeconds += telemetry.fkSeconds;
+        jacobianSeconds += telemetry.jacobianSeconds;
+        stepSeconds += telemetry.stepSeconds;
+        if (telemetry.totalSeconds > slowestSeconds) {
+            slowestSeconds = telemetry.totalSeconds;
+            slowestUpdate = i;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("updates: %d\n", numOfUpdates);
+    printf("converged: %d\n", converged);
+    printf("stopped by budget: %d\n", exhausted);
+    printf("iterations: %ld (%.2f per update)\n", iterations, iterations / (double)numOfUpdates);
+    printf("squared error: mean %g, max %g\n", sumError / numOfUpdates, maxError);
+    printf("step halvings: %ld, rejected damped steps: %ld\n", halvings, rejectedSteps);
+    printf("end effector evaluations: %ld (%.2f per update)\n", fkEvaluations,
+           fkEvaluations / (double)numOfUpdates);
+    printf("time: %.4f s (%.0f updates per second)\n", seconds, numOfUpdates / seconds);
+    printf("solver time: fk %.3f ms, jacobian %.3f ms, step %.3f ms\n",
+           fkSeconds * 1e3, jacobianSeconds * 1e3, stepSeconds * 1e3);
+    printf("slowest update: %d (%.1f us)\n", slowestUpdate, slowestSeconds * 1e6);
+
+    const Chain& chain = root.getArm()->getChain();
+    printf("final parameters:");
+    for (int i = 0; i < chain.getNumOfConstraints(); ++i)
+        printf(" %g", chain.getParams()[i]);
+    printf("\n");
+
+    return 0;
+}
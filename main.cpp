@@ -1,6 +1,6 @@
-#include "src/root.h"
+#include "src/viewer.h"
 
-Root* g_pRoot = NULL;
+Viewer* g_pRoot = NULL;
 
 void myDisplayFunc(void) {
     g_pRoot->render();
@@ -22,7 +22,7 @@ void handleInput(unsigned char key, int x, int y) {
 
 int main(int argc, char** argv)
 {
-    g_pRoot = new Root;
+    g_pRoot = new Viewer;
 
     if (argc != 2)
     {
@@ -1,18 +1,32 @@
 #ifndef __incl_arm__
 #define __incl_arm__
 
+#include "chain.h"
+#include "chainsolver.h"
 #include "joint.h"
+#include "threadpool.h"
 
 #include <iostream> //remove later
-#include <list>
+#include <vector>
 
+//The Joint objects describe the arm for parsing and rendering; their state
+//lives in m_chain, which is what m_solver actually walks. The solver's kernel
+//is rebuilt on every append so that a chain matching a compiled shape gets
+//the fixed-size kernel.
 class Arm
 {
-    std::list<Joint*> m_joints;
+    std::vector<Joint*> m_joints;
     Joint* m_pLastJoint;
+    Chain m_chain;
+    ChainSolver m_solver;
+
+    Arm(const Arm&);
+    Arm& operator=(const Arm&);
 
 public:
-    Arm(void) {
+    Arm(void):
+    m_solver(&m_chain)
+    {
     	m_pLastJoint = NULL;
     }
 
@@ -20,20 +34,45 @@ public:
     	return m_pLastJoint;
     }
 
-    std::list<Joint*> getJoints() {
+    const std::vector<Joint*>& getJoints() const {
     	return m_joints;
     }
 
+    const Chain& getChain() const {
+        return m_chain;
+    }
+
+    //Replaces every joint parameter, e.g. with a pose solved elsewhere
+    void setParams(const float* params) {
+        m_chain.setParams(params);
+    }
+
+    ChainSolver& getSolver() {
+        return m_solver;
+    }
+
     void appendJoint(Joint* joint);
 
     Eigen::Vector3f getEndEffector(void) const;
     void approachPoint(const Eigen::Vector3f& point, const float strength);
+    SolveResult solve(const Eigen::Vector3f& goal);
+
+    //Solves count targets from the arm's current pose, or from seeds when
+    //given (getChain().getNumOfConstraints() floats per target), writing one
+    //parameter vector per target to solutions. The arm itself is not moved.
+    void solveBatch(const Eigen::Vector3f* targets, int count, const float* seeds,
+                    float* solutions, SolveResult* results) const;
 
-    void render(float interpolation);
+    //As above, spread over pool's workers with one chain and solver per
+    //worker. Every target is solved independently, so the output is the
+    //same as the serial call whatever the thread count or scheduling.
+    void solveBatch(const Eigen::Vector3f* targets, int count, const float* seeds,
+                    float* solutions, SolveResult* results, ThreadPool& pool) const;
 
     //Debugging purposes, can remove later
     void print() {
-    	std::list<Joint*>::iterator iter;
+    	std::cout << "Kernel: " << m_solver.getKernel()->getInstance() << std::endl;
+    	std::vector<Joint*>::iterator iter;
     	int i = 0;
     	for (iter = m_joints.begin(); iter != m_joints.end(); ++iter) {
     		std::cout << "Joint " << i << ": ";
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ccd.h"
+
+#define CCD_EPSILON 1e-6f
+
+void
+CcdSolver::resize(int numOfJoints)
+{
+    m_rotations.resize(numOfJoints);
+    m_origins.resize(numOfJoints);
+}
+
+//Angle about unit axis that turns the lever arm to the tip towards the one
+//to the goal, both projected onto the plane normal to axis
+static float
+planarAngle(const Eigen::Vector3f& axis, const Eigen::Vector3f& toTip,
+            const Eigen::Vector3f& toGoal)
+{
+    Eigen::Vector3f tip = toTip - axis * axis.dot(toTip);
+    Eigen::Vector3f goal = toGoal - axis * axis.dot(toGoal);
+    if (tip.squaredNorm() < CCD_EPSILON || goal.squaredNorm() < CCD_EPSILON)
+        return 0;
+    return std::atan2(axis.dot(tip.cross(goal)), tip.dot(goal));
+}
+
+void
+CcdSolver::approach(Chain& chain, const Eigen::Vector3f& goal, float strength)
+{
+    //Joints are visited tip to base and a joint only moves what is outboard
+    //of it, so the inboard frames read here stay valid for the whole sweep
+    //and the tip can be carried along instead of recomputed
+    int n = chain.getNumOfJoints();
+    for (int i = 0; i < n; ++i) {
+        m_rotations[i] = chain.getRotation(i);
+        m_origins[i] = chain.getOrigin(i);
+    }
+    Eigen::Vector3f tip = chain.getEndEffector();
+
+    for (int i = n - 1; i >= 0; --i) {
+        const Eigen::Matrix3f& rotation = m_rotations[i];
+        const Eigen::Vector3f& origin = m_origins[i];
+        const float* state = chain.getParams() + chain.getOffset(i);
+
+        switch (chain.getType(i)) {
+            case PIN_JOINT: {
+                Eigen::Vector3f axis = rotation.col(2);
+                float angle = planarAngle(axis, tip - origin, goal - origin) * strength;
+                chain.changeConstraint(i, 0, angle);
+                tip = origin + Eigen::AngleAxisf(angle, axis) * (tip - origin);
+                break;
+            }
+            case DOUBLE_PIN_JOINT: {
+                //R = Rz(a) * Ry(b): b turns about the y axis after Rz(a), a
+                //about z; the outboard axis goes first
+                Eigen::Vector3f axisY = rotation * Eigen::Vector3f(-std::sin(state[0]),
+                                                                   std::cos(state[0]), 0);
+                float angle = planarAngle(axisY, tip - origin, goal - origin) * strength;
+                chain.changeConstraint(i, 1, angle);
+                tip = origin + Eigen::AngleAxisf(angle, axisY) * (tip - origin);
+
+                Eigen::Vector3f axisZ = rotation.col(2);
+                angle = planarAngle(axisZ, tip - origin, goal - origin) * strength;
+                chain.changeConstraint(i, 0, angle);
+                tip = origin + Eigen::AngleAxisf(angle, axisZ) * (tip - origin);
+                break;
+            }
+            case BALL_JOINT: {
+                Eigen::Vector3f toTip = tip - origin;
+                Eigen::Vector3f toGoal = goal - origin;
+                if (toTip.squaredNorm() < CCD_EPSILON || toGoal.squaredNorm() < CCD_EPSILON)
+                    break;
+                Eigen::AngleAxisf turn(Eigen::Quaternionf::FromTwoVectors(toTip, toGoal));
+                turn.angle() *= strength;
+
+                //The turn is in the base frame; the joint's own rotation is
+                //relative to its inboard frame
+                Eigen::Matrix3f local = rotation.transpose() * turn.toRotationMatrix() *
+                                        rotation * chain.getTransform(i).block<3, 3>(0, 0);
+                Eigen::AngleAxisf fitted(local);
+                Eigen::Vector3f expMap = fitted.axis() * fitted.angle();
+                for (int k = 0; k < 3; ++k)
+                    chain.changeConstraint(i, k, expMap(k) - state[k]);
+                tip = origin + turn * toTip;
+                break;
+            }
+            case PRISM_JOINT: {
+                Eigen::Vector3f axis = rotation.col(0);
+                //Written directly: clamping the slide instead can leave the
+                //sum a rounding error below zero, which changeConstraint rejects
+                float extension = std::max(state[0] + axis.dot(goal - tip) * strength, 0.0f);
+                float slide = extension - state[0];
+                chain.editParams(i)[0] = extension;
+                tip += axis * slide;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef __incl_ccd__
+#define __incl_ccd__
+
+#include <vector>
+
+#include "chain.h"
+
+//Cyclic coordinate descent over a Chain: sweeps from the tip to the base
+//and gives each joint, on its own, the update that brings the end effector
+//closest to the goal. Every joint type has that update in closed form: a
+//pin axis turns the tip's lever arm onto the goal's in its plane, a double
+//pin does so about each of its two axes, a ball joint takes the shortest
+//rotation between them and a prismatic joint slides by the error along its
+//axis. There is no Jacobian or factorization, so a sweep costs O(n); it is
+//a cheap way to get near the goal, not a fast way to converge on it.
+class CcdSolver
+{
+    std::vector<Eigen::Matrix3f> m_rotations;
+    std::vector<Eigen::Vector3f> m_origins;
+
+public:
+    //Sizes the scratch space for a chain of numOfJoints joints
+    void resize(int numOfJoints);
+
+    //One sweep toward goal, scaling every update by strength
+    void approach(Chain& chain, const Eigen::Vector3f& goal, float strength);
+};
+
+#endif
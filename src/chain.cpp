@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <cmath>
+
+#include "chain.h"
+
+void
+Chain::append(JointType type, float length, const float* params)
+{
+    int numOfConstraints = 0;
+    switch (type) {
+        case BALL_JOINT:
+            numOfConstraints = BallJoint::DOF;
+            break;
+        case PRISM_JOINT:
+            numOfConstraints = PrismJoint::DOF;
+            m_extensible = true;
+            break;
+        case PIN_JOINT:
+            numOfConstraints = PinJoint::DOF;
+            break;
+        case DOUBLE_PIN_JOINT:
+            numOfConstraints = DoublePinJoint::DOF;
+            break;
+    }
+
+    m_types.push_back(type);
+    m_lengths.push_back(length);
+    m_params.insert(m_params.end(), params, params + numOfConstraints);
+    m_offsets.push_back(m_params.size());
+    m_reach += length;
+
+    m_rotations.push_back(Eigen::Matrix3f::Identity());
+    m_origins.push_back(Eigen::Vector3f::Zero());
+    m_trialRotations.push_back(Eigen::Matrix3f::Identity());
+    m_trialOrigins.push_back(Eigen::Vector3f::Zero());
+}
+
+void
+Chain::setParams(const float* params)
+{
+    std::copy(params, params + m_params.size(), m_params.begin());
+    m_validFrames = 0;
+}
+
+void
+Chain::setTrialParams(const float* params)
+{
+    std::copy(params, params + m_params.size(), m_params.begin());
+    m_rotations.swap(m_trialRotations);
+    m_origins.swap(m_trialOrigins);
+    m_validFrames = getNumOfJoints();
+}
+
+static void
+changeState(int type, float* state, int num, float delta)
+{
+    switch (type) {
+        case BALL_JOINT:
+            BallJoint::changeConstraint(state, num, delta);
+            break;
+        case PRISM_JOINT:
+            PrismJoint::changeConstraint(state, num, delta);
+            break;
+        case PIN_JOINT:
+            PinJoint::changeConstraint(state, num, delta);
+            break;
+        case DOUBLE_PIN_JOINT:
+            DoublePinJoint::changeConstraint(state, num, delta);
+            break;
+    }
+}
+
+static Eigen::Matrix4f
+getStateTransform(int type, const float* state)
+{
+    switch (type) {
+        case BALL_JOINT:
+            return BallJoint::getTransform(state);
+        case PRISM_JOINT:
+            return PrismJoint::getTransform(state);
+        case PIN_JOINT:
+            return PinJoint::getTransform(state);
+        case DOUBLE_PIN_JOINT:
+            return DoublePinJoint::getTransform(state);
+    }
+    return Eigen::Matrix4f::Identity();
+}
+
+void
+Chain::changeConstraint(int joint, int num, float delta)
+{
+    changeState(m_types[joint], editParams(joint), num, delta);
+}
+
+void
+Chain::applyDelta(const float* delta, float strength)
+{
+    for (int i = 0; i < getNumOfJoints(); ++i) {
+        for (int j = m_offsets[i]; j < m_offsets[i + 1]; ++j) {
+            changeConstraint(i, j - m_offsets[i], delta[j] * strength);
+        }
+    }
+}
+
+void
+Chain::wrapRotations(void)
+{
+    for (int i = 0; i < getNumOfJoints(); ++i) {
+        if (m_types[i] != BALL_JOINT)
+            continue;
+        Eigen::Map<Eigen::Vector3f> expMap(&m_params[m_offsets[i]]);
+        float angle = expMap.norm();
+        if (angle <= M_PI)
+            continue;
+        //Whole turns about the same axis are the same rotation
+        float wrapped = angle - 2 * M_PI * std::floor(angle / (2 * M_PI) + 0.5f);
+        expMap *= wrapped / angle;
+        invalidate(i);
+    }
+}
+
+static Eigen::Quaternionf
+getQuaternion(const float* state)
+{
+    Eigen::Map<const Eigen::Vector3f> expMap(state);
+    float angle = expMap.norm();
+    if (angle == 0)
+        return Eigen::Quaternionf::Identity();
+    return Eigen::Quaternionf(Eigen::AngleAxisf(angle, expMap / angle));
+}
+
+void
+Chain::interpolate(const float* from, const float* to, float t, float* params) const
+{
+    for (int i = 0; i < getNumOfJoints(); ++i) {
+        int offset = m_offsets[i];
+        if (m_types[i] != BALL_JOINT) {
+            for (int j = offset; j < m_offsets[i + 1]; ++j)
+                params[j] = from[j] + (to[j] - from[j]) * t;
+            continue;
+        }
+        Eigen::AngleAxisf blend(getQuaternion(from + offset).slerp(t, getQuaternion(to + offset)));
+        Eigen::Map<Eigen::Vector3f>(params + offset) = blend.axis() * blend.angle();
+    }
+}
+
+void
+Chain::getStepped(const float* delta, float strength, float* params) const
+{
+    std::copy(m_params.begin(), m_params.end(), params);
+    for (int i = 0; i < getNumOfJoints(); ++i) {
+        for (int j = m_offsets[i]; j < m_offsets[i + 1]; ++j) {
+            changeState(m_types[i], params + m_offsets[i], j - m_offsets[i], delta[j] * strength);
+        }
+    }
+}
+
+Eigen::Matrix4f
+Chain::getTransform(int joint) const
+{
+    return getStateTransform(m_types[joint], &m_params[m_offsets[joint]]);
+}
+
+Eigen::Vector3f
+Chain::transform(int joint, const Eigen::Vector3f& point) const
+{
+    const float* state = &m_params[m_offsets[joint]];
+    switch (m_types[joint]) {
+        case BALL_JOINT:
+            return BallJoint::transform(state, point);
+        case PRISM_JOINT:
+            return PrismJoint::transform(state, point);
+        case PIN_JOINT:
+            return PinJoint::transform(state, point);
+        case DOUBLE_PIN_JOINT:
+            return DoublePinJoint::transform(state, point);
+    }
+    return point;
+}
+
+void
+Chain::updateFrames(void) const
+{
+    for (int i = m_validFrames; i < getNumOfJoints(); ++i) {
+        Eigen::Matrix4f transform = getTransform(i);
+        m_origins[i + 1] = m_origins[i] +
+                           m_rotations[i] * (transform.block<3, 1>(0, 3) +
+                                             transform.block<3, 1>(0, 0) * m_lengths[i]);
+        m_rotations[i + 1] = m_rotations[i] * transform.block<3, 3>(0, 0);
+    }
+    m_validFrames = getNumOfJoints();
+}
+
+Eigen::Vector3f
+Chain::getEndEffector(void) const
+{
+    updateFrames();
+    return m_origins[getNumOfJoints()];
+}
+
+Eigen::Vector3f
+Chain::getEndEffector(const float* params) const
+{
+    for (int i = 0; i < getNumOfJoints(); ++i) {
+        Eigen::Matrix4f transform = getStateTransform(m_types[i], params + m_offsets[i]);
+        m_trialOrigins[i + 1] = m_trialOrigins[i] +
+                                m_trialRotations[i] * (transform.block<3, 1>(0, 3) +
+                                                       transform.block<3, 1>(0, 0) * m_lengths[i]);
+        m_trialRotations[i + 1] = m_trialRotations[i] * transform.block<3, 3>(0, 0);
+    }
+    return m_trialOrigins[getNumOfJoints()];
+}
+
+//Writes one joint's columns, rotated from its inboard frame into the base frame
+template <class JointKind>
+static void
+fillJacobian(Eigen::MatrixXf& jacobian, int offset, const float* state,
+             const Eigen::Matrix3f& rotation, const Eigen::Vector3f& point)
+{
+    jacobian.block<3, JointKind::DOF>(0, offset) =
+        rotation * JointKind::getJacobian(state, point);
+}
+
+Eigen::Vector3f
+Chain::getJacobian(Eigen::MatrixXf& jacobian) const
+{
+    updateFrames();
+    Eigen::Vector3f tip = m_origins[getNumOfJoints()];
+    jacobian.resize(3, getNumOfConstraints());
+
+    for (int i = 0; i < getNumOfJoints(); ++i) {
+        Eigen::Vector3f point = m_rotations[i].transpose() * (tip - m_origins[i]);
+        const float* state = &m_params[m_offsets[i]];
+
+        switch (m_types[i]) {
+            case BALL_JOINT:
+                fillJacobian<BallJoint>(jacobian, m_offsets[i], state, m_rotations[i], point);
+                break;
+            case PRISM_JOINT:
+                fillJacobian<PrismJoint>(jacobian, m_offsets[i], state, m_rotations[i], point);
+                break;
+            case PIN_JOINT:
+                fillJacobian<PinJoint>(jacobian, m_offsets[i], state, m_rotations[i], point);
+                break;
+            case DOUBLE_PIN_JOINT:
+                fillJacobian<DoublePinJoint>(jacobian, m_offsets[i], state, m_rotations[i], point);
+                break;
+        }
+    }
+
+    return tip;
+}
@@ -0,0 +1,151 @@
+#ifndef __incl_chain__
+#define __incl_chain__
+
+#include <vector>
+
+#include "joint.h"
+
+//Flat description of a serial chain. Joint types, parameter offsets, body
+//lengths and joint parameters each live in one contiguous array, so the
+//solver walks the chain with plain indexing instead of chasing Joint and
+//Body pointers. Joint i owns m_params[m_offsets[i]] .. m_params[m_offsets[i + 1]].
+//
+//The frame at the inboard side of every joint (plus one past the tip) is
+//cached. Frames 0 .. m_validFrames are current; changing joint i only
+//invalidates the frames outboard of it, so forward kinematics and Jacobian
+//assembly share one pass and repeated queries cost nothing.
+class Chain
+{
+    std::vector<int> m_types;
+    std::vector<int> m_offsets;
+    std::vector<float> m_lengths;
+    std::vector<float> m_params;
+    float m_reach;
+    bool m_extensible;
+
+    mutable std::vector<Eigen::Matrix3f> m_rotations;
+    mutable std::vector<Eigen::Vector3f> m_origins;
+    mutable int m_validFrames;
+    mutable std::vector<Eigen::Matrix3f> m_trialRotations;
+    mutable std::vector<Eigen::Vector3f> m_trialOrigins;
+
+    void updateFrames(void) const;
+
+public:
+    Chain(void) {
+        m_offsets.push_back(0);
+        m_reach = 0;
+        m_extensible = false;
+        m_rotations.push_back(Eigen::Matrix3f::Identity());
+        m_origins.push_back(Eigen::Vector3f::Zero());
+        m_validFrames = 0;
+        m_trialRotations = m_rotations;
+        m_trialOrigins = m_origins;
+    }
+
+    int getNumOfJoints(void) const {
+        return m_types.size();
+    }
+
+    int getNumOfConstraints(void) const {
+        return m_params.size();
+    }
+
+    int getType(int joint) const {
+        return m_types[joint];
+    }
+
+    int getOffset(int joint) const {
+        return m_offsets[joint];
+    }
+
+    float getLength(int joint) const {
+        return m_lengths[joint];
+    }
+
+    const float* getLengths(void) const {
+        return m_lengths.empty() ? NULL : &m_lengths[0];
+    }
+
+    //Sum of body lengths, ignoring prismatic extension
+    float getReach(void) const {
+        return m_reach;
+    }
+
+    //True if any joint can lengthen the chain
+    bool isExtensible(void) const {
+        return m_extensible;
+    }
+
+    const float* getParams(void) const {
+        return m_params.empty() ? NULL : &m_params[0];
+    }
+
+    //Writable parameters of one joint; frames outboard of it become stale
+    float* editParams(int joint) {
+        invalidate(joint);
+        return &m_params[m_offsets[joint]];
+    }
+
+    //Replaces every joint parameter at once
+    void setParams(const float* params);
+
+    //Same, for the params last passed to getEndEffector(params): the frames
+    //found there become the cached ones instead of being recomputed
+    void setTrialParams(const float* params);
+
+    //Marks the frames outboard of joint as stale
+    void invalidate(int joint) {
+        if (joint < m_validFrames)
+            m_validFrames = joint;
+    }
+
+    //Base-frame rotation and position of the inboard side of joint; joint
+    //getNumOfJoints() is the tip
+    const Eigen::Matrix3f& getRotation(int joint) const {
+        updateFrames();
+        return m_rotations[joint];
+    }
+
+    const Eigen::Vector3f& getOrigin(int joint) const {
+        updateFrames();
+        return m_origins[joint];
+    }
+
+    //Appends a joint, copying its current parameters. May reallocate the
+    //parameter array, invalidating earlier getParams() pointers.
+    void append(JointType type, float length, const float* params);
+
+    void changeConstraint(int joint, int num, float delta);
+    void applyDelta(const float* delta, float strength);
+
+    //Rewrites every ball joint's rotation with an angle of at most pi,
+    //leaving the pose unchanged. Near an angle of 2pi the exponential map
+    //loses rank, so a Jacobian there stalls steps it need not.
+    void wrapRotations(void);
+
+    //Pose t of the way from one set of params to another: ball joints turn
+    //along the shortest arc between their rotations, whichever exponential
+    //maps hold them, and every other parameter is blended linearly
+    void interpolate(const float* from, const float* to, float t, float* params) const;
+
+    //Writes the parameters applyDelta(delta, strength) would leave, without
+    //changing the chain
+    void getStepped(const float* delta, float strength, float* params) const;
+
+    Eigen::Matrix4f getTransform(int joint) const;
+    Eigen::Vector3f transform(int joint, const Eigen::Vector3f& point) const;
+
+    Eigen::Vector3f getEndEffector(void) const;
+
+    //End effector of this chain's shape at other parameters, computed from
+    //scratch into a second set of frames; the cached ones are neither used
+    //nor changed
+    Eigen::Vector3f getEndEffector(const float* params) const;
+
+    //Fills the 3 x getNumOfConstraints() end effector Jacobian and returns
+    //the end effector position found along the way
+    Eigen::Vector3f getJacobian(Eigen::MatrixXf& jacobian) const;
+};
+
+#endif
@@ -0,0 +1,467 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "chainsolver.h"
+
+const float ChainSolver::DEFAULT_DAMPING = 0.05f;
+const float ChainSolver::MIN_DAMPING = 0.001f;
+const float ChainSolver::MAX_DAMPING = 10.0f;
+const float ChainSolver::DEFAULT_MAX_STEP = 3.14159f / 4;
+
+ChainSolver::ChainSolver(Chain* chain)
+{
+    m_pChain = chain;
+    m_pKernel = NULL;
+    m_mode = PSEUDOINVERSE_SOLVER;
+    m_damping = DEFAULT_DAMPING;
+    m_maxStep = DEFAULT_MAX_STEP;
+    m_pTelemetry = NULL;
+    m_stepLength = 1;
+    m_appliedStrength = 1;
+    m_steppedTipKnown = false;
+    m_hybridStalled = false;
+    m_jacobianRefresh = 1;
+    m_jacobianAge = -1;
+    rebuild();
+}
+
+ChainSolver::ChainSolver(Chain* chain, const ChainSolver& other)
+{
+    m_pChain = chain;
+    m_pKernel = other.m_pKernel->clone();
+    m_savedParams.resize(chain->getNumOfConstraints());
+    m_bestParams.resize(chain->getNumOfConstraints());
+    m_delta.resize(chain->getNumOfConstraints());
+    m_trialParams.resize(chain->getNumOfConstraints());
+    m_fabrik.resize(chain->getNumOfJoints());
+    m_ccd.resize(chain->getNumOfJoints());
+    m_mode = other.m_mode;
+    m_damping = other.m_damping;
+    m_maxStep = other.m_maxStep;
+    m_budget = other.m_budget;
+    m_pTelemetry = NULL;
+    m_stepLength = 1;
+    m_appliedStrength = 1;
+    m_steppedTipKnown = false;
+    m_hybrid = other.m_hybrid;
+    m_hybridStalled = false;
+    m_jacobianRefresh = other.m_jacobianRefresh;
+    m_jacobianAge = -1;
+    m_jacobianParams.resize(chain->getNumOfConstraints());
+}
+
+void
+ChainSolver::rebuild(void)
+{
+    delete m_pKernel;
+    m_pKernel = createKernel(*m_pChain);
+    m_savedParams.resize(m_pChain->getNumOfConstraints());
+    m_bestParams.resize(m_pChain->getNumOfConstraints());
+    m_delta.resize(m_pChain->getNumOfConstraints());
+    m_trialParams.resize(m_pChain->getNumOfConstraints());
+    m_fabrik.resize(m_pChain->getNumOfJoints());
+    m_ccd.resize(m_pChain->getNumOfJoints());
+    m_jacobianParams.resize(m_pChain->getNumOfConstraints());
+    m_jacobianAge = -1;
+}
+
+Eigen::Vector3f
+ChainSolver::getEndEffector(void) const
+{
+    ScopedTimer timer(m_pTelemetry ? &m_pTelemetry->fkSeconds : NULL);
+    if (m_pTelemetry)
+        m_pTelemetry->fkEvaluations++;
+    return m_pKernel->getEndEffector(*m_pChain);
+}
+
+Eigen::Vector3f
+ChainSolver::getEndEffector(const float* params) const
+{
+    ScopedTimer timer(m_pTelemetry ? &m_pTelemetry->fkSeconds : NULL);
+    if (m_pTelemetry)
+        m_pTelemetry->fkEvaluations++;
+    return m_pKernel->getEndEffector(*m_pChain, params);
+}
+
+Eigen::Vector3f
+ChainSolver::getSteppedEndEffector(void) const
+{
+    return m_steppedTipKnown ? m_steppedTip : getEndEffector();
+}
+
+bool
+ChainSolver::warmStart(const Eigen::Vector3f& goal, const float* guess)
+{
+    float currentError = (goal - getEndEffector()).squaredNorm();
+    m_savedParams = Eigen::Map<const Eigen::VectorXf>(m_pChain->getParams(),
+                                                      m_pChain->getNumOfConstraints());
+
+    //Moving there as a step keeps the joints' own limits, which an
+    //extrapolated guess may cross
+    m_delta = Eigen::Map<const Eigen::VectorXf>(guess, m_pChain->getNumOfConstraints()) -
+                   m_savedParams;
+    m_pChain->applyDelta(m_delta.data(), 1);
+    if ((goal - getEndEffector()).squaredNorm() < currentError)
+        return true;
+
+    m_pChain->setParams(m_savedParams.data());
+    return false;
+}
+
+Eigen::Vector3f
+ChainSolver::updateJacobian(void)
+{
+    double* seconds = m_pTelemetry ? &m_pTelemetry->jacobianSeconds : NULL;
+    if (m_jacobianRefresh <= 1) {
+        ScopedTimer timer(seconds);
+        return m_pKernel->updateJacobian(*m_pChain);
+    }
+
+    Eigen::Map<const Eigen::VectorXf> params(m_pChain->getParams(),
+                                             m_pChain->getNumOfConstraints());
+    Eigen::Vector3f tip;
+    if (m_jacobianAge < 0 || m_jacobianAge + 1 >= m_jacobianRefresh) {
+        ScopedTimer timer(seconds);
+        tip = m_pKernel->updateJacobian(*m_pChain);
+        m_jacobianAge = 0;
+    } else {
+        //Secant step: only the end effector is evaluated, not every joint's
+        //columns, and it is counted and timed as forward kinematics
+        tip = getEndEffector();
+        ScopedTimer timer(seconds);
+        m_delta = params - m_jacobianParams;
+        m_pKernel->refineJacobian(tip - m_jacobianTip, m_delta.data());
+        m_jacobianAge++;
+    }
+    m_jacobianParams = params;
+    m_jacobianTip = tip;
+    return tip;
+}
+
+Eigen::Vector3f
+ChainSolver::clampGoal(const Eigen::Vector3f& point) const
+{
+    Eigen::Vector3f goal = point;
+    float armLength = m_pChain->getReach();
+    if (goal.norm() > armLength && !m_pChain->isExtensible())
+        goal = (goal / goal.norm()) * armLength;
+    return goal;
+}
+
+void
+ChainSolver::approachPoint(const Eigen::Vector3f& point, const float strength)
+{
+    //The chain may have been moved since the last step, and a single step
+    //is not part of a solve whose Newton steps have stalled
+    m_steppedTipKnown = false;
+    m_hybridStalled = false;
+    approachWith(m_mode, clampGoal(point), strength);
+}
+
+void
+ChainSolver::approachWith(SolverMode mode, const Eigen::Vector3f& goal, const float strength)
+{
+    //HYBRID_SOLVER only picks another mode, and may still use the last
+    //step's end effector to do so
+    if (mode != HYBRID_SOLVER)
+        m_steppedTipKnown = false;
+    m_appliedStrength = strength;
+
+    switch (mode) {
+        case PSEUDOINVERSE_SOLVER: {
+            Eigen::Vector3f deltaP = goal - updateJacobian();
+            const float* step;
+            {
+                ScopedTimer timer(m_pTelemetry ? &m_pTelemetry->stepSeconds : NULL);
+                step = m_pKernel->solve(PSEUDOINVERSE_SOLVER, deltaP, 0);
+            }
+            approachSearched(goal, deltaP, step, strength);
+            break;
+        }
+        case DLS_SOLVER: {
+            Eigen::Vector3f deltaP = goal - updateJacobian();
+            approachDamped(goal, deltaP, strength);
+            break;
+        }
+        case SDLS_SOLVER: {
+            Eigen::Vector3f deltaP = goal - updateJacobian();
+            const float* step;
+            {
+                ScopedTimer timer(m_pTelemetry ? &m_pTelemetry->stepSeconds : NULL);
+                step = m_pKernel->solve(SDLS_SOLVER, deltaP, m_maxStep);
+            }
+            approachSearched(goal, deltaP, step, strength);
+            break;
+        }
+        case FABRIK_SOLVER:
+            approachFabrik(goal, strength);
+            m_jacobianAge = -1;
+            break;
+        case CCD_SOLVER: {
+            ScopedTimer timer(m_pTelemetry ? &m_pTelemetry->stepSeconds : NULL);
+            m_ccd.approach(*m_pChain, goal, strength);
+            m_jacobianAge = -1;
+            break;
+        }
+        case HYBRID_SOLVER:
+            approachHybrid(goal, strength);
+            break;
+    }
+}
+
+void
+ChainSolver::approachDamped(const Eigen::Vector3f& goal,
+                            const Eigen::Vector3f& deltaP,
+                            const float strength)
+{
+    //Levenberg-Marquardt: accept a step only if it reduces the error,
+    //relaxing the damping after a success and stiffening it after a failure
+    float startError = deltaP.squaredNorm();
+    m_savedParams = Eigen::Map<const Eigen::VectorXf>(m_pChain->getParams(),
+                                                      m_pChain->getNumOfConstraints());
+
+    for (int attempt = 0; attempt < MAX_DAMPING_ATTEMPTS; ++attempt) {
+        {
+            ScopedTimer timer(m_pTelemetry ? &m_pTelemetry->stepSeconds : NULL);
+            m_pChain->applyDelta(m_pKernel->solve(DLS_SOLVER, deltaP, m_damping), strength);
+        }
+
+        Eigen::Vector3f tip = getEndEffector();
+        if ((goal - tip).squaredNorm() < startError) {
+            m_damping = std::max(m_damping * 0.5f, MIN_DAMPING);
+            m_steppedTip = tip;
+            m_steppedTipKnown = true;
+            return;
+        }
+
+        if (m_pTelemetry)
+            m_pTelemetry->rejectedSteps++;
+        m_pChain->setParams(m_savedParams.data());
+        if (m_damping >= MAX_DAMPING)
+            return;
+        m_damping = std::min(m_damping * 4.0f, MAX_DAMPING);
+    }
+}
+
+void
+ChainSolver::approachSearched(const Eigen::Vector3f& goal,
+                              const Eigen::Vector3f& deltaP,
+                              const float* step,
+                              const float strength)
+{
+    //Backtracking line search under the Armijo condition. It runs along
+    //the parameter change the joints actually make for the full step, so a
+    //limit that rejects part of it is already accounted for, and slope is
+    //the rate the error falls at its start. Trial poses are evaluated on
+    //m_trialParams, and only the accepted one is written to the chain.
+    Eigen::Map<const Eigen::VectorXf> params(m_pChain->getParams(),
+                                             m_pChain->getNumOfConstraints());
+    m_pChain->getStepped(step, strength, m_trialParams.data());
+    m_delta = m_trialParams - params;
+
+    float error = deltaP.squaredNorm();
+    float slope = std::max(2 * deltaP.dot(m_pKernel->predict(m_delta.data())), 0.0f);
+    float length = m_stepLength;
+    float bestLength = 0;
+    float bestError = error;
+    Eigen::Vector3f bestTip = goal - deltaP;
+    float trialLength = 0;
+
+    for (int attempt = 0; attempt < MAX_LINE_SEARCH_STEPS; ++attempt) {
+        trialLength = length;
+        m_trialParams = params + length * m_delta;
+        Eigen::Vector3f tip = getEndEffector(m_trialParams.data());
+        float trialError = (goal - tip).squaredNorm();
+
+        if (trialError <= error - ARMIJO_SLOPE * length * slope) {
+            m_pKernel->setTrialParams(*m_pChain, m_trialParams.data());
+            m_steppedTip = tip;
+            m_steppedTipKnown = true;
+            m_appliedStrength = length * strength;
+            //The next search starts where this one ended, or further out if
+            //this one took its first trial
+            m_stepLength = attempt == 0 ? std::min(length * 2, 1.0f) : length;
+            return;
+        }
+
+        if (trialError < bestError) {
+            bestError = trialError;
+            bestLength = length;
+            bestTip = tip;
+        }
+
+        //Next trial at the minimum of the parabola through the error and
+        //slope at the start and the error here, kept within [0.1, 0.5] of
+        //this length
+        float curvature = trialError - error + slope * length;
+        float minimum = curvature > 0 ? slope * length * length / (2 * curvature) : 0;
+        length = std::min(std::max(minimum, length * 0.1f), length * 0.5f);
+        if (m_pTelemetry)
+            m_pTelemetry->halvings++;
+    }
+
+    //No trial decreased the error enough; settle for the one that decreased
+    //it most, if any did. Its end effector is known, and if it was the last
+    //trial its frames are too.
+    m_appliedStrength = bestLength * strength;
+    if (bestLength > 0) {
+        if (bestLength == trialLength) {
+            m_pKernel->setTrialParams(*m_pChain, m_trialParams.data());
+        } else {
+            m_trialParams = params + bestLength * m_delta;
+            m_pChain->setParams(m_trialParams.data());
+        }
+        m_steppedTip = bestTip;
+        m_steppedTipKnown = true;
+        m_stepLength = bestLength;
+    }
+}
+
+void
+ChainSolver::approachFabrik(const Eigen::Vector3f& goal, const float strength)
+{
+    ScopedTimer timer(m_pTelemetry ? &m_pTelemetry->stepSeconds : NULL);
+    if (strength >= 1) {
+        m_fabrik.approach(*m_pChain, goal);
+        return;
+    }
+
+    //A partial step moves the parameters part of the way to the fitted pose
+    m_savedParams = Eigen::Map<const Eigen::VectorXf>(m_pChain->getParams(),
+                                                      m_pChain->getNumOfConstraints());
+    m_fabrik.approach(*m_pChain, goal);
+    m_delta = Eigen::Map<const Eigen::VectorXf>(m_pChain->getParams(),
+                                                m_pChain->getNumOfConstraints()) - m_savedParams;
+    m_pChain->setParams(m_savedParams.data());
+    m_pChain->applyDelta(m_delta.data(), strength);
+}
+
+void
+ChainSolver::approachHybrid(const Eigen::Vector3f& goal, const float strength)
+{
+    if (m_hybridStalled) {
+        approachWith(m_hybrid.stallMode, goal, strength);
+        return;
+    }
+    float error = (goal - getSteppedEndEffector()).squaredNorm();
+    if (error > m_hybrid.radius * m_hybrid.radius) {
+        approachWith(m_hybrid.globalMode, goal, strength);
+        return;
+    }
+
+    //A Newton step that stalls hands this and every later step of the solve
+    //to the stall mode, which also takes a step now so that the iteration
+    //does not end the solve for lack of progress. Before damped steps, ball
+    //joints wound past pi are unwound, as their Jacobian would stall those too.
+    approachWith(PSEUDOINVERSE_SOLVER, goal, strength);
+    if ((goal - getSteppedEndEffector()).squaredNorm() > error * m_hybrid.stallRatio) {
+        m_hybridStalled = true;
+        if (m_hybrid.stallMode == DLS_SOLVER) {
+            m_pChain->wrapRotations();
+            m_jacobianAge = -1;
+        }
+        approachWith(m_hybrid.stallMode, goal, strength);
+    }
+}
+
+SolveResult
+ChainSolver::solve(const Eigen::Vector3f& goal)
+{
+    if (m_pTelemetry)
+        m_pTelemetry->reset();
+    ScopedTimer timer(m_pTelemetry ? &m_pTelemetry->totalSeconds : NULL);
+
+    SolveResult result;
+    result.iterations = 0;
+    result.exhausted = false;
+    m_hybridStalled = false;
+    m_jacobianAge = -1;
+    m_stepLength = 1;
+    m_steppedTip = getEndEffector();
+    m_steppedTipKnown = true;
+
+    float prevError = 1000;
+    float currError = (goal - m_steppedTip).squaredNorm();
+    if (m_pTelemetry)
+        m_pTelemetry->initialError = currError;
+
+    bool limited = m_budget.isLimited();
+    std::chrono::steady_clock::time_point deadline;
+    if (m_budget.maxSeconds > 0)
+        deadline = std::chrono::steady_clock::now() +
+                   std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                       std::chrono::duration<double>(m_budget.maxSeconds));
+    float bestError = currError;
+    if (limited)
+        m_bestParams = Eigen::Map<const Eigen::VectorXf>(m_pChain->getParams(),
+                                                         m_pChain->getNumOfConstraints());
+
+    Eigen::Vector3f target = clampGoal(goal);
+    float b = 1;
+    while (currError > CONVERGED_ERROR)
+    {
+        if ((m_budget.maxIterations > 0 && result.iterations >= m_budget.maxIterations) ||
+            (m_budget.maxSeconds > 0 && std::chrono::steady_clock::now() >= deadline)) {
+            result.exhausted = true;
+            break;
+        }
+
+        prevError = currError;
+        approachWith(m_mode, target, b);
+        bool refined = m_jacobianAge > 0;
+        currError = (goal - getSteppedEndEffector()).squaredNorm();
+        if (m_pTelemetry)
+            m_pTelemetry->record(m_appliedStrength, currError);
+        //A refined Jacobian that stops paying off is rebuilt before the next
+        //step, and only a step from a rebuilt one can end the solve as stalled
+        if (currError > prevError * BROYDEN_MIN_PROGRESS)
+            m_jacobianAge = -1;
+        if (currError > prevError) {
+            b /= 2;
+            if (m_pTelemetry)
+                m_pTelemetry->halvings++;
+        }
+        result.iterations++;
+
+        if (limited && currError < bestError) {
+            bestError = currError;
+            m_bestParams = Eigen::Map<const Eigen::VectorXf>(m_pChain->getParams(),
+                                                             m_pChain->getNumOfConstraints());
+        }
+
+        if (std::abs(prevError - currError) <= STALLED_PROGRESS && !refined)
+            break;
+    }
+
+    if (limited && bestError < currError) {
+        m_pChain->setParams(m_bestParams.data());
+        currError = bestError;
+    }
+
+    result.converged = currError <= CONVERGED_ERROR;
+    result.error = currError;
+    if (m_pTelemetry) {
+        m_pTelemetry->iterations = result.iterations;
+        m_pTelemetry->converged = result.converged;
+        m_pTelemetry->finalError = currError;
+    }
+    return result;
+}
+
+void
+ChainSolver::solveBatch(const float* start, const Eigen::Vector3f* targets, int count,
+                        const float* seeds, float* solutions, SolveResult* results)
+{
+    int n = m_pChain->getNumOfConstraints();
+    float damping = m_damping;
+
+    for (int i = 0; i < count; ++i) {
+        m_pChain->setParams(seeds ? seeds + i * n : start);
+        m_damping = damping;
+        results[i] = solve(targets[i]);
+        std::copy(m_pChain->getParams(), m_pChain->getParams() + n, solutions + i * n);
+    }
+
+    m_damping = damping;
+}
@@ -0,0 +1,229 @@
+#ifndef __incl_chainsolver__
+#define __incl_chainsolver__
+
+#include "ccd.h"
+#include "chain.h"
+#include "fabrik.h"
+#include "kernel.h"
+#include "solver.h"
+#include "telemetry.h"
+
+#define MAX_DAMPING_ATTEMPTS 8
+#define MAX_LINE_SEARCH_STEPS 8
+#define ARMIJO_SLOPE 0.25f //Fraction of the predicted decrease a line search step must achieve
+#define CONVERGED_ERROR 0.0001f
+#define STALLED_PROGRESS 0.000001f
+#define BROYDEN_MIN_PROGRESS 0.5f //Largest error ratio per step that keeps a refined Jacobian
+
+//Outcome of one ChainSolver::solve call
+struct SolveResult
+{
+    bool converged;
+    bool exhausted; //Stopped by the SolveBudget before converging or stalling
+    int iterations;
+    float error; //Squared distance from the end effector to the goal
+};
+
+//Limits on one ChainSolver::solve call; zero means no limit. With either
+//limit set the solve is anytime: when it stops it leaves the chain in the
+//best pose it reached, not the last one.
+struct SolveBudget
+{
+    int maxIterations;
+    double maxSeconds;
+
+    SolveBudget(int iterations = 0, double seconds = 0) {
+        maxIterations = iterations;
+        maxSeconds = seconds;
+    }
+
+    bool isLimited(void) const {
+        return maxIterations > 0 || maxSeconds > 0;
+    }
+};
+
+//How HYBRID_SOLVER picks its step. Far from the goal a cheap global method
+//gets the end effector close; within radius Newton (pseudoinverse) steps
+//converge quickly, until one leaves more than stallRatio of the squared
+//error it started from. That means a singularity, and stallMode takes over
+//for the rest of the solve: the global method by default, which has no
+//Jacobian to lose rank, or damped least squares.
+struct HybridPolicy
+{
+    SolverMode globalMode; //FABRIK_SOLVER or CCD_SOLVER
+    float radius;
+    float stallRatio;
+    SolverMode stallMode; //DLS_SOLVER, FABRIK_SOLVER or CCD_SOLVER
+
+    HybridPolicy(SolverMode mode = FABRIK_SOLVER, float radius_ = 0.1f, float stall = 0.5f) {
+        globalMode = mode;
+        radius = radius_;
+        stallRatio = stall;
+        stallMode = mode;
+    }
+};
+
+//Drives one Chain toward a goal: picks the kernel for the chain's shape,
+//holds the solver settings and the adaptive damping, and runs the
+//convergence loop. Everything it touches is its own or its chain's, so
+//solvers over separate chains are independent of each other.
+class ChainSolver
+{
+    Chain* m_pChain;
+    ChainKernel* m_pKernel;
+    Eigen::VectorXf m_savedParams;
+    Eigen::VectorXf m_bestParams;
+    Eigen::VectorXf m_delta;
+    Eigen::VectorXf m_trialParams;
+    FabrikSolver m_fabrik;
+    CcdSolver m_ccd;
+
+    SolverMode m_mode;
+    float m_damping; //Current lambda for DLS_SOLVER, adapted every step
+    float m_maxStep; //Largest parameter change per step for SDLS_SOLVER
+    SolveBudget m_budget;
+    SolveTelemetry* m_pTelemetry;
+
+    float m_stepLength; //First trial of the next line search, grown back after easy steps
+    float m_appliedStrength; //Of the last step, after any line search
+    bool m_steppedTipKnown; //The last step already evaluated where it left the end effector
+    Eigen::Vector3f m_steppedTip;
+
+    HybridPolicy m_hybrid;
+    bool m_hybridStalled; //A Newton step has stalled during this solve
+
+    int m_jacobianRefresh; //Steps per full Jacobian build; 1 builds every step
+    int m_jacobianAge; //Steps since the last full build, -1 when it must be rebuilt
+    Eigen::VectorXf m_jacobianParams; //Pose and end effector of the kernel's Jacobian
+    Eigen::Vector3f m_jacobianTip;
+
+    Eigen::Vector3f clampGoal(const Eigen::Vector3f& point) const;
+    Eigen::Vector3f updateJacobian(void);
+    Eigen::Vector3f getEndEffector(const float* params) const;
+    Eigen::Vector3f getSteppedEndEffector(void) const;
+    void approachWith(SolverMode mode, const Eigen::Vector3f& goal, const float strength);
+    void approachDamped(const Eigen::Vector3f& goal,
+                        const Eigen::Vector3f& deltaP,
+                        const float strength);
+    void approachSearched(const Eigen::Vector3f& goal,
+                          const Eigen::Vector3f& deltaP,
+                          const float* step,
+                          const float strength);
+    void approachFabrik(const Eigen::Vector3f& goal, const float strength);
+    void approachHybrid(const Eigen::Vector3f& goal, const float strength);
+
+    ChainSolver(const ChainSolver&);
+    ChainSolver& operator=(const ChainSolver&);
+
+public:
+    static const float DEFAULT_DAMPING;
+    static const float MIN_DAMPING;
+    static const float MAX_DAMPING;
+    static const float DEFAULT_MAX_STEP;
+
+    ChainSolver(Chain* chain);
+
+    //Solver for another chain of the same shape, with other's settings
+    ChainSolver(Chain* chain, const ChainSolver& other);
+
+    ~ChainSolver(void) {
+        delete m_pKernel;
+    }
+
+    //Must be called after joints are appended to the chain
+    void rebuild(void);
+
+    const Chain& getChain() const {
+        return *m_pChain;
+    }
+
+    const ChainKernel* getKernel() const {
+        return m_pKernel;
+    }
+
+    SolverMode getMode() const {
+        return m_mode;
+    }
+
+    void setMode(SolverMode mode) {
+        m_mode = mode;
+    }
+
+    float getDamping() const {
+        return m_damping;
+    }
+
+    void setDamping(float damping) {
+        m_damping = damping;
+    }
+
+    float getMaxStep() const {
+        return m_maxStep;
+    }
+
+    void setMaxStep(float maxStep) {
+        m_maxStep = maxStep;
+    }
+
+    const HybridPolicy& getHybridPolicy() const {
+        return m_hybrid;
+    }
+
+    void setHybridPolicy(const HybridPolicy& policy) {
+        m_hybrid = policy;
+    }
+
+    int getJacobianRefresh() const {
+        return m_jacobianRefresh;
+    }
+
+    //Builds the Jacobian from the joints only every refresh steps of a
+    //solve; the steps in between correct the last one with Broyden updates
+    //from the observed end effector motion. 1 builds it every step.
+    void setJacobianRefresh(int refresh) {
+        m_jacobianRefresh = refresh;
+        m_jacobianAge = -1;
+    }
+
+    const SolveBudget& getBudget() const {
+        return m_budget;
+    }
+
+    void setBudget(const SolveBudget& budget) {
+        m_budget = budget;
+    }
+
+    //Filled in by every solve() while set; NULL turns telemetry off
+    void setTelemetry(SolveTelemetry* telemetry) {
+        m_pTelemetry = telemetry;
+    }
+
+    SolveTelemetry* getTelemetry() const {
+        return m_pTelemetry;
+    }
+
+    Eigen::Vector3f getEndEffector(void) const;
+
+    //Moves the chain to guess if the end effector lands closer to goal
+    //there than where it is now; returns whether it moved
+    bool warmStart(const Eigen::Vector3f& goal, const float* guess);
+
+    //One step toward point, scaled by strength
+    void approachPoint(const Eigen::Vector3f& point, const float strength);
+
+    //Steps toward goal until the squared error drops below 1e-4, stops
+    //improving or the budget runs out. Pseudoinverse and SDLS steps are
+    //line searched so the error never grows; for the other modes the step
+    //is halved whenever it does.
+    SolveResult solve(const Eigen::Vector3f& goal);
+
+    //Solves count independent problems on this solver's chain. Problem i
+    //starts from seeds + i * n, or from start when seeds is NULL, where n is
+    //the chain's number of constraints; its solution is written to
+    //solutions + i * n. The damping is reset to its current value before
+    //each problem, so every result is independent of the others.
+    void solveBatch(const float* start, const Eigen::Vector3f* targets, int count,
+                    const float* seeds, float* solutions, SolveResult* results);
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cmath>
+
+#include "fabrik.h"
+
+#define FABRIK_EPSILON 1e-6f
+#define TWO_PI 6.2831853f
+
+void
+FabrikSolver::resize(int numOfJoints)
+{
+    m_pivots.reserve(numOfJoints + 1);
+    m_points.resize(numOfJoints + 1);
+    m_lengths.resize(numOfJoints);
+}
+
+//Moves point to distance length from anchor, along the line between them
+static void
+place(Eigen::Vector3f& point, const Eigen::Vector3f& anchor, float length)
+{
+    Eigen::Vector3f direction = point - anchor;
+    float distance = direction.norm();
+    if (distance > FABRIK_EPSILON)
+        point = anchor + direction * (length / distance);
+}
+
+//Angle equal to target up to whole turns and closest to current, so fitted
+//parameters do not jump by 2 pi between updates
+static float
+nearestAngle(float current, float target)
+{
+    return current + std::remainder(target - current, TWO_PI);
+}
+
+void
+FabrikSolver::aim(int type, float* state, const Eigen::Vector3f& direction)
+{
+    //direction is a unit vector in the joint's inboard frame; the joint's
+    //rotation should carry its body's x axis onto it
+    switch (type) {
+        case BALL_JOINT: {
+            //Shortest rotation from x: about x cross direction
+            Eigen::Vector3f axis(0, -direction(2), direction(1));
+            float sine = axis.norm();
+            float angle = std::atan2(sine, direction(0));
+            if (sine > FABRIK_EPSILON)
+                axis *= angle / sine;
+            else
+                axis = Eigen::Vector3f(0, 0, direction(0) > 0 ? 0 : angle);
+            state[0] = axis(0);
+            state[1] = axis(1);
+            state[2] = axis(2);
+            break;
+        }
+        case PIN_JOINT:
+            state[0] = nearestAngle(state[0], std::atan2(direction(1), direction(0)));
+            break;
+        case DOUBLE_PIN_JOINT: {
+            //Rz(a) * Ry(b) * x = (cos a cos b, sin a cos b, -sin b)
+            float planar = std::sqrt(direction(0) * direction(0) + direction(1) * direction(1));
+            if (planar > FABRIK_EPSILON)
+                state[0] = nearestAngle(state[0], std::atan2(direction(1), direction(0)));
+            state[1] = nearestAngle(state[1], std::atan2(-direction(2), planar));
+            break;
+        }
+        case PRISM_JOINT:
+            break;
+    }
+}
+
+void
+FabrikSolver::approach(Chain& chain, const Eigen::Vector3f& goal)
+{
+    int n = chain.getNumOfJoints();
+    m_pivots.clear();
+    for (int i = 0; i < n; ++i) {
+        if (chain.getType(i) != PRISM_JOINT)
+            m_pivots.push_back(i);
+    }
+    m_pivots.push_back(n);
+
+    int last = m_pivots.size() - 1;
+    for (int k = 0; k <= last; ++k)
+        m_points[k] = chain.getOrigin(m_pivots[k]);
+    for (int k = 0; k < last; ++k)
+        m_lengths[k] = (m_points[k + 1] - m_points[k]).norm();
+
+    //The first prismatic joint inside a segment makes the goal reachable
+    //if it can: extending when the goal is too far, retracting when its
+    //segment is so long the others cannot fold back to the goal
+    Eigen::Vector3f base = m_points[0];
+    float distance = (goal - base).norm();
+    float reach = 0;
+    for (int k = 0; k < last; ++k)
+        reach += m_lengths[k];
+
+    int stretched = -1;
+    float stretch = 0;
+    for (int k = 0; k < last; ++k) {
+        if (m_pivots[k + 1] - m_pivots[k] == 1)
+            continue;
+        stretched = m_pivots[k] + 1;
+        float extension = chain.getParams()[chain.getOffset(stretched)];
+        if (distance > reach)
+            stretch = distance - reach;
+        else if (2 * m_lengths[k] - reach > distance)
+            stretch = std::max(distance + reach - 2 * m_lengths[k], -extension);
+        m_lengths[k] += stretch;
+        break;
+    }
+
+    //Backward from the goal, then forward from the base
+    m_points[last] = goal;
+    for (int k = last - 1; k >= 0; --k)
+        place(m_points[k], m_points[k + 1], m_lengths[k]);
+    m_points[0] = base;
+    for (int k = 0; k < last; ++k)
+        place(m_points[k + 1], m_points[k], m_lengths[k]);
+
+    //Fit base to tip, carrying the frames along as Chain::updateFrames does
+    //so that each joint aims from where its parent actually put it
+    Eigen::Matrix3f rotation = chain.getRotation(0);
+    Eigen::Vector3f origin = chain.getOrigin(0);
+    int next = 0;
+    for (int i = 0; i < n; ++i) {
+        if (i == m_pivots[next]) {
+            next++;
+            Eigen::Vector3f direction = rotation.transpose() * (m_points[next] - origin);
+            if (direction.norm() > FABRIK_EPSILON)
+                aim(chain.getType(i), chain.editParams(i), direction.normalized());
+        }
+
+        if (i == stretched && stretch != 0) {
+            float* state = chain.editParams(i);
+            state[0] = std::max(state[0] + stretch, 0.0f);
+        }
+
+        Eigen::Matrix4f transform = chain.getTransform(i);
+        origin += rotation * (transform.block<3, 1>(0, 3) +
+                              transform.block<3, 1>(0, 0) * chain.getLength(i));
+        rotation = rotation * transform.block<3, 3>(0, 0);
+    }
+}
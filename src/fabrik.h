@@ -0,0 +1,33 @@
+#ifndef __incl_fabrik__
+#define __incl_fabrik__
+
+#include <vector>
+
+#include "chain.h"
+
+//Forward And Backward Reaching IK (Aristidou and Lasenby) over a Chain.
+//The origins of the rotating joints are moved as points: backward from the
+//goal to the base and forward again, each segment keeping its length. A
+//prismatic joint cannot turn, so it only lengthens the segment of the
+//joint before it, and only extends when the goal is out of reach. The
+//chain's joint parameters are then fitted, base to tip, to aim every
+//segment at its moved outboard point. Ball and double pin joints can aim
+//anywhere and pin joints only within their plane. No Jacobian or
+//factorization is involved, so one pass costs O(n).
+class FabrikSolver
+{
+    std::vector<int> m_pivots; //Rotating joints, then the tip
+    std::vector<Eigen::Vector3f> m_points; //Origin of each pivot
+    std::vector<float> m_lengths;
+
+    static void aim(int type, float* state, const Eigen::Vector3f& direction);
+
+public:
+    //Sizes the scratch space for a chain of numOfJoints joints
+    void resize(int numOfJoints);
+
+    //One backward and forward pass toward goal, written to chain's parameters
+    void approach(Chain& chain, const Eigen::Vector3f& goal);
+};
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef __incl_fixedkernel__
+#define __incl_fixedkernel__
+
+#include <algorithm>
+#include <limits>
+
+#include "kernel.h"
+
+template <JointType Type> struct JointKind;
+template <> struct JointKind<BALL_JOINT> { typedef BallJoint Type; };
+template <> struct JointKind<PRISM_JOINT> { typedef PrismJoint Type; };
+template <> struct JointKind<PIN_JOINT> { typedef PinJoint Type; };
+template <> struct JointKind<DOUBLE_PIN_JOINT> { typedef DoublePinJoint Type; };
+
+//Compile-time walk over a list of joint types. Index and Offset are the
+//current joint and its first parameter; rotations[i] and origins[i] hold the
+//base-frame inboard frame of joint i, with one extra entry for the tip. The
+//empty list ends the recursion.
+template <int Index, int Offset, JointType... Types>
+struct FixedLinks
+{
+    enum { DOF = 0 };
+
+    static void frames(const float* params, const float* lengths,
+                       Eigen::Matrix3f* rotations, Eigen::Vector3f* origins) {}
+
+    template <class Jacobian>
+    static void jacobian(Jacobian& jacobian, const float* params,
+                         const Eigen::Matrix3f* rotations, const Eigen::Vector3f* origins,
+                         const Eigen::Vector3f& tip) {}
+};
+
+template <int Index, int Offset, JointType First, JointType... Rest>
+struct FixedLinks<Index, Offset, First, Rest...>
+{
+    typedef typename JointKind<First>::Type Kind;
+    typedef FixedLinks<Index + 1, Offset + Kind::DOF, Rest...> Next;
+
+    enum { DOF = Kind::DOF + Next::DOF };
+
+    static void frames(const float* params, const float* lengths,
+                       Eigen::Matrix3f* rotations, Eigen::Vector3f* origins) {
+        Eigen::Matrix4f transform = Kind::getTransform(params + Offset);
+        origins[Index + 1] = origins[Index] +
+                             rotations[Index] * (transform.block<3, 1>(0, 3) +
+                                                 transform.block<3, 1>(0, 0) * lengths[Index]);
+        rotations[Index + 1] = rotations[Index] * transform.block<3, 3>(0, 0);
+        Next::frames(params, lengths, rotations, origins);
+    }
+
+    template <class Jacobian>
+    static void jacobian(Jacobian& jacobian, const float* params,
+                         const Eigen::Matrix3f* rotations, const Eigen::Vector3f* origins,
+                         const Eigen::Vector3f& tip) {
+        Eigen::Vector3f point = rotations[Index].transpose() * (tip - origins[Index]);
+        jacobian.template block<3, Kind::DOF>(0, Offset) =
+            rotations[Index] * Kind::getJacobian(params + Offset, point);
+        Next::jacobian(jacobian, params, rotations, origins, tip);
+    }
+};
+
+//Kernel for one chain shape known at compile time. The joint loop is
+//unrolled with no virtual calls, and the Jacobian, SVD and step are
+//fixed-size Eigen objects.
+template <JointType... Types>
+class FixedKernel : public ChainKernel
+{
+    typedef FixedLinks<0, 0, Types...> Links;
+
+public:
+    enum { JOINTS = sizeof...(Types), DOF = Links::DOF };
+    typedef Eigen::Matrix<float, 3, DOF> Jacobian;
+    typedef Eigen::Matrix<float, DOF, 1> Step;
+
+private:
+    Jacobian m_jacobian;
+    Step m_step;
+    Eigen::JacobiSVD<Jacobian> m_svd;
+    //Frames for m_frameParams of m_pFrameChain, kept from the last end
+    //effector query or Jacobian update so that a repeated query costs a
+    //comparison; and frames for the last trial params
+    mutable Eigen::Matrix3f m_rotations[JOINTS + 1];
+    mutable Eigen::Vector3f m_origins[JOINTS + 1];
+    mutable Step m_frameParams;
+    mutable const Chain* m_pFrameChain;
+    mutable Eigen::Matrix3f m_trialRotations[JOINTS + 1];
+    mutable Eigen::Vector3f m_trialOrigins[JOINTS + 1];
+    mutable Step m_trialParams;
+
+    void updateFrames(const Chain& chain) const {
+        Eigen::Map<const Step> params(chain.getParams());
+        if (m_pFrameChain == &chain && params == m_frameParams)
+            return;
+        Links::frames(chain.getParams(), chain.getLengths(), m_rotations, m_origins);
+        m_frameParams = params;
+        m_pFrameChain = &chain;
+    }
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    FixedKernel(void):
+    m_svd(3, DOF, Eigen::ComputeFullU | Eigen::ComputeFullV),
+    m_pFrameChain(NULL)
+    {
+        m_rotations[0].setIdentity();
+        m_origins[0].setZero();
+        m_trialRotations[0].setIdentity();
+        m_trialOrigins[0].setZero();
+        m_trialParams.setConstant(std::numeric_limits<float>::quiet_NaN());
+    }
+
+    static bool matches(const Chain& chain) {
+        const JointType types[] = {Types...};
+        if (chain.getNumOfJoints() != JOINTS)
+            return false;
+        for (int i = 0; i < JOINTS; ++i) {
+            if (chain.getType(i) != types[i])
+                return false;
+        }
+        return true;
+    }
+
+    virtual ChainKernel* clone(void) const {
+        FixedKernel* kernel = new FixedKernel(*this);
+        kernel->m_pFrameChain = NULL;
+        return kernel;
+    }
+
+    virtual Eigen::Vector3f getEndEffector(const Chain& chain) const {
+        updateFrames(chain);
+        return m_origins[JOINTS];
+    }
+
+    virtual Eigen::Vector3f getEndEffector(const Chain& chain, const float* params) const {
+        Links::frames(params, chain.getLengths(), m_trialRotations, m_trialOrigins);
+        m_trialParams = Eigen::Map<const Step>(params);
+        return m_trialOrigins[JOINTS];
+    }
+
+    virtual void setTrialParams(Chain& chain, const float* params) const {
+        chain.setParams(params);
+        if (Eigen::Map<const Step>(params) != m_trialParams)
+            return;
+        std::swap_ranges(m_trialRotations, m_trialRotations + JOINTS + 1, m_rotations);
+        std::swap_ranges(m_trialOrigins, m_trialOrigins + JOINTS + 1, m_origins);
+        m_frameParams = m_trialParams;
+        m_pFrameChain = &chain;
+    }
+
+    virtual Eigen::Vector3f updateJacobian(const Chain& chain) {
+        updateFrames(chain);
+        Links::jacobian(m_jacobian, chain.getParams(), m_rotations, m_origins,
+                        m_origins[JOINTS]);
+        return m_origins[JOINTS];
+    }
+
+    virtual void refineJacobian(const Eigen::Vector3f& deltaX, const float* deltaTheta) {
+        updateBroyden(m_jacobian, deltaX, deltaTheta);
+    }
+
+    virtual Eigen::Vector3f predict(const float* deltaTheta) const {
+        return m_jacobian * Eigen::Map<const Step>(deltaTheta);
+    }
+
+    virtual const float* solve(SolverMode mode, const Eigen::Vector3f& deltaP,
+                               float parameter) {
+        switch (mode) {
+            case PSEUDOINVERSE_SOLVER:
+                solveMinimumNorm(m_jacobian, deltaP, m_step);
+                break;
+            case DLS_SOLVER:
+                solveDamped(m_jacobian, deltaP, parameter, m_step);
+                break;
+            case SDLS_SOLVER:
+                m_svd.compute(m_jacobian);
+                solveSelectivelyDamped(m_jacobian, m_svd, deltaP, parameter, m_step);
+                break;
+            case FABRIK_SOLVER: //Not Jacobian based, never asked for a step
+            case CCD_SOLVER:
+            case HYBRID_SOLVER:
+                m_step.setZero();
+                break;
+        }
+        return m_step.data();
+    }
+
+    virtual std::string getInstance(void) const {
+        return "Fixed Kernel";
+    }
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef __incl_ik__
+#define __incl_ik__
+
+//Everything libik.a provides: the joint types, Arm and Chain, the single,
+//batched, threaded and lane-parallel solvers, and Root for loading scene
+//files. None of it depends on OpenGL or GLUT.
+#include "arm.h"
+#include "chain.h"
+#include "ccd.h"
+#include "chainsolver.h"
+#include "fabrik.h"
+#include "joint.h"
+#include "lanekernel.h"
+#include "lookahead.h"
+#include "posebuffer.h"
+#include "root.h"
+#include "scheduler.h"
+#include "threadpool.h"
+#include "tracker.h"
+
+#endif
@@ -1,21 +1,5 @@
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <sys/time.h>
-#endif
-
-#ifdef __APPLE__
-#include <GLUT/glut.h>
-#include <OpenGL/gl.h>
-#include <OpenGL/glu.h>
-#else
-#include <GL/glut.h>
-#include <GL/glu.h>
-#endif
-
 #include "joint.h"
-
-#define EPSILON 0.015625f
+#include "chain.h"
 
 Body*
 Joint::getInboardBody(void) const
@@ -41,28 +25,46 @@ Joint::setOutboardBody(Body* b) {
     return;
 }
 
-//--------------BallJoint------------------
+const float*
+Joint::getState(void) const
+{
+    if (m_pChain)
+        return m_pChain->getParams() + m_pChain->getOffset(m_index);
+    return m_localState;
+}
 
-int
-BallJoint::getNumOfConstraints(void) const
+float*
+Joint::editState(void)
 {
-    return 3;
+    if (m_pChain)
+        return m_pChain->editParams(m_index);
+    return m_localState;
 }
 
 void
-BallJoint::changeConstraint(int num, float delta)
+Joint::attach(Chain* chain, int index)
 {
-    m_expMap(num) += delta;
+    m_pChain = chain;
+    m_index = index;
+}
+
+//--------------BallJoint------------------
+
+void
+BallJoint::changeConstraint(float* state, int num, float delta)
+{
+    state[num] += delta;
 }
 
 Eigen::Vector3f
-BallJoint::transform(const Eigen::Vector3f& point) const
+BallJoint::transform(const float* state, const Eigen::Vector3f& point)
 {
-    float angle = m_expMap.norm();
-    Eigen::Vector3f axis = m_expMap;
-    if (angle != 0) {
-        axis = axis/axis.norm();
-    }
+    Eigen::Map<const Eigen::Vector3f> expMap(state);
+    float angle = expMap.norm();
+    //The zero rotation has no axis
+    if (angle == 0)
+        return point;
+    Eigen::Vector3f axis = expMap / angle;
 
     Eigen::Matrix3f transform;
 
@@ -77,47 +79,42 @@ BallJoint::transform(const Eigen::Vector3f& point) const
     return transform * point;
 }
 
-Eigen::MatrixXf
-BallJoint::getJacobian(void)
+BallJoint::Jacobian
+BallJoint::getJacobian(const float* state, const Eigen::Vector3f& point)
 {
-    Eigen::Matrix3f jacobian;
-    Eigen::Vector3f endPoint;
-    Eigen::Vector3f deltaEnd;
-
-    Eigen::Vector3f initialConfig;
-
-    Eigen::Vector3f bodyVector(m_outboard->getLength(), 0, 0);
-    endPoint = transform(bodyVector);
-
-    initialConfig = m_expMap;
-    m_expMap = initialConfig + Eigen::Vector3f(EPSILON, 0, 0);
-    deltaEnd = transform(bodyVector) - endPoint;
-    jacobian.col(0) = deltaEnd;
-
-    m_expMap = initialConfig + Eigen::Vector3f(0, EPSILON, 0);
-    deltaEnd = transform(bodyVector) - endPoint;
-    jacobian.col(1) = deltaEnd;
-
-    m_expMap = initialConfig + Eigen::Vector3f(0, 0, EPSILON);
-    deltaEnd = transform(bodyVector) - endPoint;
-    jacobian.col(2) = deltaEnd;
-
-    m_expMap = initialConfig;
+    //d(R(v) * p)/dv = -[R(v) * p]x * Jl(v), Jl being the left Jacobian of SO(3)
+    Eigen::Map<const Eigen::Vector3f> expMap(state);
+    float angle = expMap.norm();
+
+    Eigen::Matrix3f skew;
+    skew <<           0,  -expMap(2),  expMap(1),
+              expMap(2),           0, -expMap(0),
+             -expMap(1),   expMap(0),          0;
+
+    Eigen::Matrix3f left = Eigen::Matrix3f::Identity();
+    if (angle > 1e-3f) {
+        left += skew * ((1 - cos(angle)) / (angle * angle)) +
+                skew * skew * ((angle - sin(angle)) / (angle * angle * angle));
+    } else {
+        left += skew * 0.5f + skew * skew * (1 / 6.0f);
+    }
 
-    return jacobian / EPSILON;
-}
+    Eigen::Matrix3f cross;
+    cross <<         0,  point(2), -point(1),
+             -point(2),         0,  point(0),
+              point(1), -point(0),         0;
 
-void BallJoint::render(void) {
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    GLUquadric* quad = gluNewQuadric();
-    gluSphere(quad, 0.03, 10, 10);
+    return cross * left;
 }
 
 Eigen::Matrix4f
-BallJoint::getTransform(void) const
+BallJoint::getTransform(const float* state)
 {
-    float angle = m_expMap.norm();
-    Eigen::Vector3f axis = m_expMap / m_expMap.norm();
+    Eigen::Map<const Eigen::Vector3f> expMap(state);
+    float angle = expMap.norm();
+    if (angle == 0)
+        return Eigen::Matrix4f::Identity();
+    Eigen::Vector3f axis = expMap / angle;
     Eigen::Vector4f homogen;
     homogen <<  axis(0), axis(1), axis(2), 0;
 
@@ -137,127 +134,131 @@ BallJoint::getTransform(void) const
     return transform;
 }
 
-//--------------PinJoint------------------
-
 int
-PinJoint::getNumOfConstraints(void) const
+BallJoint::getNumOfConstraints(void) const
 {
-    return 1;
+    return DOF;
 }
 
 void
-PinJoint::changeConstraint(int num, float delta)
+BallJoint::changeConstraint(int num, float delta)
 {
-    if (num == 0)
-        m_angle += delta;
+    changeConstraint(editState(), num, delta);
 }
 
 Eigen::Vector3f
-PinJoint::transform(const Eigen::Vector3f& point) const
+BallJoint::transform(const Eigen::Vector3f& point) const
 {
-    float newX = point(0) * cos(m_angle) - point(1) * sin(m_angle);
-    float newY = point(1) * cos(m_angle) + point(0) * sin(m_angle);
-    return Eigen::Vector3f(newX, newY, point(2));
+    return transform(getState(), point);
 }
 
 Eigen::MatrixXf
-PinJoint::getJacobian(void)
+BallJoint::getJacobian(const Eigen::Vector3f& point) const
 {
-    Eigen::Matrix<float, 3, 1> jacobian;
-    Eigen::Vector3f endPoint;
-    Eigen::Vector3f deltaEnd;
+    return getJacobian(getState(), point);
+}
 
-    float initialConfig;
+Eigen::Matrix4f
+BallJoint::getTransform(void) const
+{
+    return getTransform(getState());
+}
 
-    Eigen::Vector3f bodyVector(m_outboard->getLength(), 0, 0);
-    endPoint = transform(bodyVector);
+//--------------PinJoint------------------
 
-    initialConfig = m_angle;
-    m_angle = initialConfig + EPSILON;
-    deltaEnd = transform(bodyVector) - endPoint;
-    jacobian.col(0) = deltaEnd;
+void
+PinJoint::changeConstraint(float* state, int num, float delta)
+{
+    if (num == 0)
+        state[0] += delta;
+}
 
-    m_angle = initialConfig;
+Eigen::Vector3f
+PinJoint::transform(const float* state, const Eigen::Vector3f& point)
+{
+    float newX = point(0) * cos(state[0]) - point(1) * sin(state[0]);
+    float newY = point(1) * cos(state[0]) + point(0) * sin(state[0]);
+    return Eigen::Vector3f(newX, newY, point(2));
+}
 
-    return jacobian / EPSILON;
+PinJoint::Jacobian
+PinJoint::getJacobian(const float* state, const Eigen::Vector3f& point)
+{
+    //Rotation about z: z x point
+    return Jacobian(-point(1), point(0), 0);
 }
 
 Eigen::Matrix4f
-PinJoint::getTransform(void) const
+PinJoint::getTransform(const float* state)
 {
     Eigen::Matrix4f transform;
 
-    transform <<  cos(m_angle), -sin(m_angle), 0, 0,
-                  sin(m_angle), cos(m_angle), 0, 0,
-                  0,            0,            1, 0,
-                  0,            0,            0, 1;
+    transform <<  cos(state[0]), -sin(state[0]), 0, 0,
+                  sin(state[0]), cos(state[0]), 0, 0,
+                  0,             0,             1, 0,
+                  0,             0,             0, 1;
 
     return transform;
 }
 
-void PinJoint::render(void) {
-    glPushMatrix();
-    glTranslatef(0, 0, -0.04);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    GLUquadric* quad = gluNewQuadric();
-    gluCylinder(quad, 0.02, 0.02, 0.08, 10, 10);
-
-    gluDisk(quad, 0, 0.02, 10, 10);
-    glTranslatef(0, 0, 0.08);
-    gluDisk(quad, 0, 0.02, 10, 10);
-
-    glPopMatrix();
-}
-
-//--------------PrismJoint------------------
-
 int
-PrismJoint::getNumOfConstraints(void) const
+PinJoint::getNumOfConstraints(void) const
 {
-    return 1;
+    return DOF;
 }
 
 void
-PrismJoint::changeConstraint(int num, float delta)
+PinJoint::changeConstraint(int num, float delta)
 {
-    if (num == 0 && m_length + delta >= 0)
-        m_length += delta;
+    changeConstraint(editState(), num, delta);
 }
 
 Eigen::Vector3f
-PrismJoint::transform(const Eigen::Vector3f& point) const
+PinJoint::transform(const Eigen::Vector3f& point) const
 {
-    return point + Eigen::Vector3f(m_length, 0, 0);
+    return transform(getState(), point);
 }
 
 Eigen::MatrixXf
-PrismJoint::getJacobian(void)
+PinJoint::getJacobian(const Eigen::Vector3f& point) const
 {
-    Eigen::Matrix<float, 3, 1> jacobian;
-    Eigen::Vector3f endPoint;
-    Eigen::Vector3f deltaEnd;
+    return getJacobian(getState(), point);
+}
 
-    float initialConfig;
+Eigen::Matrix4f
+PinJoint::getTransform(void) const
+{
+    return getTransform(getState());
+}
 
-    Eigen::Vector3f bodyVector(m_outboard->getLength(), 0, 0);
-    endPoint = transform(bodyVector);
+//--------------PrismJoint------------------
 
-    initialConfig = m_length;
-    m_length = initialConfig + EPSILON;
-    deltaEnd = transform(bodyVector) - endPoint;
-    jacobian.col(0) = deltaEnd;
+void
+PrismJoint::changeConstraint(float* state, int num, float delta)
+{
+    if (num == 0 && state[0] + delta >= 0)
+        state[0] += delta;
+}
 
-    m_length = initialConfig;
+Eigen::Vector3f
+PrismJoint::transform(const float* state, const Eigen::Vector3f& point)
+{
+    return point + Eigen::Vector3f(state[0], 0, 0);
+}
 
-    return jacobian / EPSILON;
+PrismJoint::Jacobian
+PrismJoint::getJacobian(const float* state, const Eigen::Vector3f& point)
+{
+    //Extension along x moves every outboard point along x
+    return Jacobian(1, 0, 0);
 }
 
 Eigen::Matrix4f
-PrismJoint::getTransform(void) const
+PrismJoint::getTransform(const float* state)
 {
     Eigen::Matrix4f transform;
 
-    transform << 1, 0, 0, m_length,
+    transform << 1, 0, 0, state[0],
                  0, 1, 0, 0,
                  0, 0, 1, 0,
                  0, 0, 0, 1;
@@ -265,111 +266,115 @@ PrismJoint::getTransform(void) const
     return transform;
 }
 
-void PrismJoint::render(void) {
-    glPushMatrix();
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glRotatef(90, 0, 1, 0);
-    glTranslatef(0, 0, -m_length);
-    GLUquadric* quad = gluNewQuadric();
-    gluCylinder(quad, 0.03, 0.03, m_length, 10, 10);
-    glPopMatrix();
+int
+PrismJoint::getNumOfConstraints(void) const
+{
+    return DOF;
 }
 
-//--------------DoublePinJoint------------------
+void
+PrismJoint::changeConstraint(int num, float delta)
+{
+    changeConstraint(editState(), num, delta);
+}
 
-int
-DoublePinJoint::getNumOfConstraints(void) const
+Eigen::Vector3f
+PrismJoint::transform(const Eigen::Vector3f& point) const
 {
-    return 2;
+    return transform(getState(), point);
 }
 
+Eigen::MatrixXf
+PrismJoint::getJacobian(const Eigen::Vector3f& point) const
+{
+    return getJacobian(getState(), point);
+}
+
+Eigen::Matrix4f
+PrismJoint::getTransform(void) const
+{
+    return getTransform(getState());
+}
+
+//--------------DoublePinJoint------------------
+
 void
-DoublePinJoint::changeConstraint(int num, float delta)
+DoublePinJoint::changeConstraint(float* state, int num, float delta)
 {
-    if (num == 0)
-        m_angle_x += delta;
-    else if (num == 1)
-        m_angle_y += delta;
+    if (num == 0 || num == 1)
+        state[num] += delta;
 }
 
 Eigen::Vector3f
-DoublePinJoint::transform(const Eigen::Vector3f& point) const
+DoublePinJoint::transform(const float* state, const Eigen::Vector3f& point)
 {
     Eigen::Vector4f homogen;
     homogen <<      point(0), point(1), point(2), 1;
     Eigen::Vector4f result;
-    result = getTransform() * homogen;
+    result = getTransform(state) * homogen;
     Eigen::Vector3f toReturn;
     toReturn <<     result(0), result(1), result(2);
     return toReturn;
 }
 
-Eigen::MatrixXf
-DoublePinJoint::getJacobian(void)
+DoublePinJoint::Jacobian
+DoublePinJoint::getJacobian(const float* state, const Eigen::Vector3f& point)
 {
-    Eigen::Matrix<float, 3, 2> jacobian;
-    Eigen::Vector3f endPoint;
-    Eigen::Vector3f deltaEnd;
-
-    float initialConfig_x;
-    float initialConfig_y;
-
-    Eigen::Vector3f bodyVector(m_outboard->getLength(), 0, 0);
-    endPoint = transform(bodyVector);
-
-    initialConfig_x = m_angle_x;
-    m_angle_x = initialConfig_x + EPSILON;
-    deltaEnd = transform(bodyVector) - endPoint;
-    jacobian.col(0) = deltaEnd;
-    m_angle_x = initialConfig_x;
-
-    initialConfig_y = m_angle_y;
-    m_angle_y = initialConfig_y + EPSILON;
-    deltaEnd = transform(bodyVector) - endPoint;
-    jacobian.col(1) = deltaEnd;
-    m_angle_y = initialConfig_y;
-
-    return jacobian / EPSILON;
+    //R = Rz(x) * Ry(y): the x column is z x point, the y column is the
+    //y axis after Rz(x) crossed with point
+    Eigen::Vector3f axisY(-sin(state[0]), cos(state[0]), 0);
+
+    Jacobian jacobian;
+    jacobian.col(0) << -point(1), point(0), 0;
+    jacobian.col(1) = axisY.cross(point);
+    return jacobian;
 }
 
 Eigen::Matrix4f
-DoublePinJoint::getTransform(void) const
+DoublePinJoint::getTransform(const float* state)
 {
     Eigen::Matrix4f r1;
 
-    r1 <<         cos(m_angle_x), -sin(m_angle_x), 0, 0,
-                  sin(m_angle_x), cos(m_angle_x), 0, 0,
-                  0,            0,            1, 0,
-                  0,            0,            0, 1;
+    r1 <<         cos(state[0]), -sin(state[0]), 0, 0,
+                  sin(state[0]), cos(state[0]), 0, 0,
+                  0,             0,             1, 0,
+                  0,             0,             0, 1;
 
     Eigen::Matrix4f r2;
-    r2 <<         cos(m_angle_y),   0,  sin(m_angle_y), 0,
-                  0,                1,  0,              0,
-                  -sin(m_angle_y),  0,  cos(m_angle_y), 0,
-                  0,                0,  0,              1;     
+    r2 <<         cos(state[1]),   0,  sin(state[1]), 0,
+                  0,               1,  0,             0,
+                  -sin(state[1]),  0,  cos(state[1]), 0,
+                  0,               0,  0,             1;
 
     return r1 * r2;
 }
 
-void DoublePinJoint::render(void) {
-    glPushMatrix();
-    glTranslatef(0, 0, -0.04);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    GLUquadric* quad = gluNewQuadric();
-    gluCylinder(quad, 0.02, 0.02, 0.08, 10, 10);
+int
+DoublePinJoint::getNumOfConstraints(void) const
+{
+    return DOF;
+}
+
+void
+DoublePinJoint::changeConstraint(int num, float delta)
+{
+    changeConstraint(editState(), num, delta);
+}
 
-    gluDisk(quad, 0, 0.02, 10, 10);
-    glTranslatef(0, 0, 0.08);
-    gluDisk(quad, 0, 0.02, 10, 10);
-    glPopMatrix();
+Eigen::Vector3f
+DoublePinJoint::transform(const Eigen::Vector3f& point) const
+{
+    return transform(getState(), point);
+}
 
-    glPushMatrix();
-    glRotatef(90, 1, 0, 0);
-    glTranslatef(0, 0, -0.04);
-    gluCylinder(quad, 0.02, 0.02, 0.08, 10, 10);
+Eigen::MatrixXf
+DoublePinJoint::getJacobian(const Eigen::Vector3f& point) const
+{
+    return getJacobian(getState(), point);
+}
 
-    gluDisk(quad, 0, 0.02, 10, 10);
-    glTranslatef(0, 0, 0.08);
-    gluDisk(quad, 0, 0.02, 10, 10);
-    glPopMatrix();
+Eigen::Matrix4f
+DoublePinJoint::getTransform(void) const
+{
+    return getTransform(getState());
 }
@@ -8,17 +8,40 @@
 
 #include "body.h"
 
+enum JointType
+{
+    BALL_JOINT,
+    PRISM_JOINT,
+    PIN_JOINT,
+    DOUBLE_PIN_JOINT
+};
+
+class Chain;
+
+//Joints keep their parameters in m_localState until they are appended to an
+//arm; afterwards they are attached to the arm's Chain and read and write its
+//arrays, so the joint objects and the solver always see the same
+//configuration. Each joint type also exposes its math as static kernels over
+//a raw state pointer, which is what Chain calls when walking its arrays.
 class Joint
 {
 protected:
     Body* m_inboard;
     Body* m_outboard;
+    Chain* m_pChain;
+    int m_index;
+    float m_localState[3];
+
+    //State pointer for writing; tells the chain its cached frames are stale
+    float* editState(void);
 
 public:
     Joint(Body* inboard, Body* outboard)
     {
         m_inboard = inboard;
         m_outboard = outboard;
+        m_pChain = NULL;
+        m_index = 0;
     }
 
     virtual Body* getInboardBody(void) const;
@@ -26,34 +49,50 @@ public:
     virtual void setInboardBody(Body* b);
     virtual void setOutboardBody(Body* b);
 
+    const float* getState(void) const;
+    void attach(Chain* chain, int index);
+
+    virtual JointType getType(void) const = 0;
     virtual int getNumOfConstraints(void) const = 0;
     virtual void changeConstraint(int num, float delta) = 0;
     virtual Eigen::Vector3f transform(const Eigen::Vector3f& point) const = 0;
-    virtual Eigen::MatrixXf getJacobian(void) = 0;
+    //Derivative of a point carried by this joint with respect to each of its
+    //constraints; point is given in the inboard frame, after transform()
+    virtual Eigen::MatrixXf getJacobian(const Eigen::Vector3f& point) const = 0;
     virtual Eigen::Matrix4f getTransform(void) const = 0;
 
-    virtual void render(void) = 0;
     virtual std::string getInstance(void) const = 0;
 };
 
 class BallJoint : public Joint
 {
-    Eigen::Vector3f m_expMap;
-
 public:
+    enum { DOF = 3 };
+    typedef Eigen::Matrix<float, 3, DOF> Jacobian;
+
     BallJoint(Body* inboard, Body* outboard):
     Joint(inboard, outboard)
     {
-        m_expMap << 1, 1, 1;
+        m_localState[0] = 1;
+        m_localState[1] = 1;
+        m_localState[2] = 1;
+    }
+
+    static void changeConstraint(float* state, int num, float delta);
+    static Eigen::Vector3f transform(const float* state, const Eigen::Vector3f& point);
+    static Jacobian getJacobian(const float* state, const Eigen::Vector3f& point);
+    static Eigen::Matrix4f getTransform(const float* state);
+
+    virtual JointType getType(void) const {
+        return BALL_JOINT;
     }
 
     virtual int getNumOfConstraints(void) const;
     virtual void changeConstraint(int num, float delta);
     virtual Eigen::Vector3f transform(const Eigen::Vector3f& point) const;
-    virtual Eigen::MatrixXf getJacobian(void);
+    virtual Eigen::MatrixXf getJacobian(const Eigen::Vector3f& point) const;
     virtual Eigen::Matrix4f getTransform(void) const;
 
-    virtual void render(void);
     virtual std::string getInstance(void) const { //Debugging purposes only
         return "Ball Joint";
     }
@@ -61,22 +100,31 @@ public:
 
 class PrismJoint : public Joint
 {
-    float m_length;
-
 public:
+    enum { DOF = 1 };
+    typedef Eigen::Matrix<float, 3, DOF> Jacobian;
+
     PrismJoint(Body* inboard, Body* outboard):
     Joint(inboard, outboard)
     {
-        m_length = 0.05;
+        m_localState[0] = 0.05;
+    }
+
+    static void changeConstraint(float* state, int num, float delta);
+    static Eigen::Vector3f transform(const float* state, const Eigen::Vector3f& point);
+    static Jacobian getJacobian(const float* state, const Eigen::Vector3f& point);
+    static Eigen::Matrix4f getTransform(const float* state);
+
+    virtual JointType getType(void) const {
+        return PRISM_JOINT;
     }
 
     virtual int getNumOfConstraints(void) const;
     virtual void changeConstraint(int num, float delta);
-    virtual Eigen::Vector3f transform(const Eigen::Vector3f& point) const; 
-    virtual Eigen::MatrixXf getJacobian(void);
+    virtual Eigen::Vector3f transform(const Eigen::Vector3f& point) const;
+    virtual Eigen::MatrixXf getJacobian(const Eigen::Vector3f& point) const;
     virtual Eigen::Matrix4f getTransform(void) const;
 
-    virtual void render(void);
     virtual std::string getInstance(void) const { //Debugging purposes only
         return "Prismatic Joint";
     }
@@ -84,22 +132,31 @@ public:
 
 class PinJoint : public Joint
 {
-    float m_angle;
-
 public:
+    enum { DOF = 1 };
+    typedef Eigen::Matrix<float, 3, DOF> Jacobian;
+
     PinJoint(Body* inboard, Body* outboard):
     Joint(inboard, outboard)
     {
-        m_angle = 0;
+        m_localState[0] = 0;
+    }
+
+    static void changeConstraint(float* state, int num, float delta);
+    static Eigen::Vector3f transform(const float* state, const Eigen::Vector3f& point);
+    static Jacobian getJacobian(const float* state, const Eigen::Vector3f& point);
+    static Eigen::Matrix4f getTransform(const float* state);
+
+    virtual JointType getType(void) const {
+        return PIN_JOINT;
     }
 
     virtual int getNumOfConstraints(void) const;
     virtual void changeConstraint(int num, float delta);
-    virtual Eigen::Vector3f transform(const Eigen::Vector3f& point) const; 
-    virtual Eigen::MatrixXf getJacobian(void);
+    virtual Eigen::Vector3f transform(const Eigen::Vector3f& point) const;
+    virtual Eigen::MatrixXf getJacobian(const Eigen::Vector3f& point) const;
     virtual Eigen::Matrix4f getTransform(void) const;
 
-    virtual void render(void);
     virtual std::string getInstance(void) const { //Debugging purposes only
         return "Pin Joint";
     }
@@ -107,24 +164,32 @@ public:
 
 class DoublePinJoint : public Joint
 {
-    float m_angle_x;
-    float m_angle_y;
-
 public:
+    enum { DOF = 2 };
+    typedef Eigen::Matrix<float, 3, DOF> Jacobian;
+
     DoublePinJoint(Body* inboard, Body* outboard):
     Joint(inboard, outboard)
     {
-        m_angle_x = 0;
-        m_angle_y = 0;
+        m_localState[0] = 0;
+        m_localState[1] = 0;
+    }
+
+    static void changeConstraint(float* state, int num, float delta);
+    static Eigen::Vector3f transform(const float* state, const Eigen::Vector3f& point);
+    static Jacobian getJacobian(const float* state, const Eigen::Vector3f& point);
+    static Eigen::Matrix4f getTransform(const float* state);
+
+    virtual JointType getType(void) const {
+        return DOUBLE_PIN_JOINT;
     }
 
     virtual int getNumOfConstraints(void) const;
     virtual void changeConstraint(int num, float delta);
-    virtual Eigen::Vector3f transform(const Eigen::Vector3f& point) const; 
-    virtual Eigen::MatrixXf getJacobian(void);
+    virtual Eigen::Vector3f transform(const Eigen::Vector3f& point) const;
+    virtual Eigen::MatrixXf getJacobian(const Eigen::Vector3f& point) const;
     virtual Eigen::Matrix4f getTransform(void) const;
 
-    virtual void render(void);
     virtual std::string getInstance(void) const { //Debugging purposes only
         return "Double Pin Joint";
     }
@@ -0,0 +1,98 @@
+#include "fixedkernel.h"
+
+Eigen::Vector3f
+DynamicKernel::getEndEffector(const Chain& chain) const
+{
+    return chain.getEndEffector();
+}
+
+Eigen::Vector3f
+DynamicKernel::getEndEffector(const Chain& chain, const float* params) const
+{
+    return chain.getEndEffector(params);
+}
+
+void
+DynamicKernel::setTrialParams(Chain& chain, const float* params) const
+{
+    chain.setTrialParams(params);
+}
+
+Eigen::Vector3f
+DynamicKernel::updateJacobian(const Chain& chain)
+{
+    return chain.getJacobian(m_workspace.jacobian);
+}
+
+void
+DynamicKernel::refineJacobian(const Eigen::Vector3f& deltaX, const float* deltaTheta)
+{
+    updateBroyden(m_workspace.jacobian, deltaX, deltaTheta);
+}
+
+Eigen::Vector3f
+DynamicKernel::predict(const float* deltaTheta) const
+{
+    Eigen::Vector3f motion = Eigen::Vector3f::Zero();
+    for (int j = 0; j < m_workspace.jacobian.cols(); ++j)
+        motion += m_workspace.jacobian.col(j) * deltaTheta[j];
+    return motion;
+}
+
+const float*
+DynamicKernel::solve(SolverMode mode, const Eigen::Vector3f& deltaP, float parameter)
+{
+    switch (mode) {
+        case PSEUDOINVERSE_SOLVER:
+            solveMinimumNorm(m_workspace.jacobian, deltaP, m_workspace.deltaTheta);
+            break;
+        case DLS_SOLVER:
+            solveDamped(m_workspace.jacobian, deltaP, parameter, m_workspace.deltaTheta);
+            break;
+        case SDLS_SOLVER:
+            m_workspace.svd.compute(m_workspace.jacobian);
+            solveSelectivelyDamped(m_workspace.jacobian, m_workspace.svd, deltaP, parameter,
+                                   m_workspace.deltaTheta);
+            break;
+        case FABRIK_SOLVER: //Not Jacobian based, never asked for a step
+        case CCD_SOLVER:
+        case HYBRID_SOLVER:
+            m_workspace.deltaTheta.setZero();
+            break;
+    }
+    return m_workspace.deltaTheta.data();
+}
+
+//Chain shapes with a compiled kernel: the sample arm, then short chains of
+//a single joint type
+template <JointType... Types>
+static ChainKernel*
+createIfMatches(const Chain& chain)
+{
+    if (FixedKernel<Types...>::matches(chain))
+        return new FixedKernel<Types...>();
+    return NULL;
+}
+
+ChainKernel*
+createKernel(const Chain& chain)
+{
+    ChainKernel* (*candidates[])(const Chain&) = {
+        createIfMatches<BALL_JOINT, DOUBLE_PIN_JOINT, BALL_JOINT, PRISM_JOINT>,
+        createIfMatches<BALL_JOINT>,
+        createIfMatches<BALL_JOINT, BALL_JOINT>,
+        createIfMatches<BALL_JOINT, BALL_JOINT, BALL_JOINT>,
+        createIfMatches<BALL_JOINT, BALL_JOINT, BALL_JOINT, BALL_JOINT>,
+        createIfMatches<PIN_JOINT, PIN_JOINT>,
+        createIfMatches<PIN_JOINT, PIN_JOINT, PIN_JOINT>,
+        createIfMatches<DOUBLE_PIN_JOINT, DOUBLE_PIN_JOINT>,
+        createIfMatches<DOUBLE_PIN_JOINT, DOUBLE_PIN_JOINT, DOUBLE_PIN_JOINT>
+    };
+
+    for (unsigned int i = 0; i < sizeof(candidates)/sizeof(candidates[0]); ++i) {
+        ChainKernel* kernel = candidates[i](chain);
+        if (kernel)
+            return kernel;
+    }
+    return new DynamicKernel(chain);
+}
@@ -0,0 +1,80 @@
+#ifndef __incl_kernel__
+#define __incl_kernel__
+
+#include <string>
+
+#include "chain.h"
+#include "solver.h"
+
+//The solver's inner loop for one chain shape: forward kinematics, Jacobian
+//assembly and the step itself. The Chain owns the joint parameters; a kernel
+//only owns scratch space, so it can be cloned to solve copies of a chain.
+class ChainKernel
+{
+public:
+    virtual ~ChainKernel(void) {}
+
+    virtual ChainKernel* clone(void) const = 0;
+
+    virtual Eigen::Vector3f getEndEffector(const Chain& chain) const = 0;
+
+    //End effector at params instead of the chain's own; the chain's
+    //parameters are untouched
+    virtual Eigen::Vector3f getEndEffector(const Chain& chain, const float* params) const = 0;
+
+    //Moves the chain to the params last passed to getEndEffector(chain, params),
+    //keeping whatever that evaluation found that the next step can use
+    virtual void setTrialParams(Chain& chain, const float* params) const = 0;
+
+    //Builds the Jacobian at the chain's current pose; returns the end effector
+    virtual Eigen::Vector3f updateJacobian(const Chain& chain) = 0;
+
+    //Corrects the last Jacobian instead of rebuilding it, given that the
+    //parameter change deltaTheta moved the end effector by deltaX
+    virtual void refineJacobian(const Eigen::Vector3f& deltaX, const float* deltaTheta) = 0;
+
+    //End effector motion the last Jacobian predicts for deltaTheta
+    virtual Eigen::Vector3f predict(const float* deltaTheta) const = 0;
+
+    //Step toward deltaP from the last Jacobian, one value per constraint.
+    //parameter is lambda for DLS_SOLVER and the step limit for SDLS_SOLVER.
+    virtual const float* solve(SolverMode mode, const Eigen::Vector3f& deltaP,
+                               float parameter) = 0;
+
+    virtual std::string getInstance(void) const = 0; //Debugging purposes only
+};
+
+//Works for any chain, walking Chain's arrays with dynamically sized matrices
+class DynamicKernel : public ChainKernel
+{
+    SolverWorkspace m_workspace;
+
+public:
+    DynamicKernel(const Chain& chain)
+    {
+        m_workspace.resize(chain.getNumOfConstraints());
+    }
+
+    virtual ChainKernel* clone(void) const {
+        return new DynamicKernel(*this);
+    }
+
+    virtual Eigen::Vector3f getEndEffector(const Chain& chain) const;
+    virtual Eigen::Vector3f getEndEffector(const Chain& chain, const float* params) const;
+    virtual void setTrialParams(Chain& chain, const float* params) const;
+    virtual Eigen::Vector3f updateJacobian(const Chain& chain);
+    virtual void refineJacobian(const Eigen::Vector3f& deltaX, const float* deltaTheta);
+    virtual Eigen::Vector3f predict(const float* deltaTheta) const;
+    virtual const float* solve(SolverMode mode, const Eigen::Vector3f& deltaP,
+                               float parameter);
+
+    virtual std::string getInstance(void) const {
+        return "Dynamic Kernel";
+    }
+};
+
+//Returns a FixedKernel if chain has one of the shapes instantiated in
+//kernel.cpp, and a DynamicKernel otherwise
+ChainKernel* createKernel(const Chain& chain);
+
+#endif
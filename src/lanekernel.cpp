@@ -0,0 +1,396 @@
+#include <algorithm>
+
+#include "lanekernel.h"
+
+//Rotation and offset of one joint relative to its inboard frame, the lane
+//counterpart of the joints' getTransform
+template <class Lane>
+static void
+localTransform(int type, const Lane* state, Lane (&rotation)[3][3], Lane (&offset)[3])
+{
+    for (int r = 0; r < 3; ++r) {
+        offset[r].setZero();
+        for (int c = 0; c < 3; ++c)
+            rotation[r][c].setConstant(r == c ? 1 : 0);
+    }
+
+    switch (type) {
+        case BALL_JOINT: {
+            //Rodrigues: R = cI + s[a]x + (1 - c)aa^T for the unit axis a
+            Lane angle = (state[0].square() + state[1].square() + state[2].square()).sqrt();
+            Lane inverse = angle.max(Lane::Constant(1e-12f)).inverse();
+            Lane x = state[0] * inverse, y = state[1] * inverse, z = state[2] * inverse;
+            Lane s = angle.sin(), c = angle.cos(), t = 1 - c;
+
+            rotation[0][0] = c + t * x * x;
+            rotation[0][1] = t * x * y - s * z;
+            rotation[0][2] = t * x * z + s * y;
+            rotation[1][0] = t * x * y + s * z;
+            rotation[1][1] = c + t * y * y;
+            rotation[1][2] = t * y * z - s * x;
+            rotation[2][0] = t * x * z - s * y;
+            rotation[2][1] = t * y * z + s * x;
+            rotation[2][2] = c + t * z * z;
+            break;
+        }
+        case PRISM_JOINT:
+            offset[0] = state[0];
+            break;
+        case PIN_JOINT: {
+            Lane s = state[0].sin(), c = state[0].cos();
+            rotation[0][0] = c;
+            rotation[0][1] = -s;
+            rotation[1][0] = s;
+            rotation[1][1] = c;
+            break;
+        }
+        case DOUBLE_PIN_JOINT: {
+            //Rz(x) * Ry(y)
+            Lane sx = state[0].sin(), cx = state[0].cos();
+            Lane sy = state[1].sin(), cy = state[1].cos();
+            rotation[0][0] = cx * cy;
+            rotation[0][1] = -sx;
+            rotation[0][2] = cx * sy;
+            rotation[1][0] = sx * cy;
+            rotation[1][1] = cx;
+            rotation[1][2] = sx * sy;
+            rotation[2][0] = -sy;
+            rotation[2][1].setZero();
+            rotation[2][2] = cy;
+            break;
+        }
+    }
+}
+
+//Jacobian columns of one joint in its inboard frame, for a point given in
+//that frame; the lane counterpart of the joints' getJacobian
+template <class Lane>
+static int
+localJacobian(int type, const Lane* state, const Lane (&point)[3], Lane (&columns)[3][3])
+{
+    switch (type) {
+        case BALL_JOINT: {
+            //-[point]x * Jl(v), Jl = I + f1[v]x + f2[v]x^2 and [v]x^2 = vv^T - |v|^2 I
+            Lane angle2 = state[0].square() + state[1].square() + state[2].square();
+            Lane angle = angle2.sqrt();
+            Lane safe = angle.max(Lane::Constant(1e-3f));
+            Lane f1 = (angle > 1e-3f).select((1 - safe.cos()) / (safe * safe), Lane::Constant(0.5f));
+            Lane f2 = (angle > 1e-3f).select((safe - safe.sin()) / (safe * safe * safe),
+                                             Lane::Constant(1 / 6.0f));
+
+            Lane left[3][3];
+            for (int r = 0; r < 3; ++r) {
+                for (int c = 0; c < 3; ++c)
+                    left[r][c] = f2 * state[r] * state[c];
+                left[r][r] += 1 - f2 * angle2;
+            }
+            left[0][1] -= f1 * state[2];
+            left[0][2] += f1 * state[1];
+            left[1][0] += f1 * state[2];
+            left[1][2] -= f1 * state[0];
+            left[2][0] -= f1 * state[1];
+            left[2][1] += f1 * state[0];
+
+            for (int c = 0; c < 3; ++c) {
+                columns[c][0] = point[2] * left[1][c] - point[1] * left[2][c];
+                columns[c][1] = point[0] * left[2][c] - point[2] * left[0][c];
+                columns[c][2] = point[1] * left[0][c] - point[0] * left[1][c];
+            }
+            return 3;
+        }
+        case PRISM_JOINT:
+            columns[0][0].setConstant(1);
+            columns[0][1].setZero();
+            columns[0][2].setZero();
+            return 1;
+        case PIN_JOINT:
+            columns[0][0] = -point[1];
+            columns[0][1] = point[0];
+            columns[0][2].setZero();
+            return 1;
+        case DOUBLE_PIN_JOINT: {
+            Lane sx = state[0].sin(), cx = state[0].cos();
+            columns[0][0] = -point[1];
+            columns[0][1] = point[0];
+            columns[0][2].setZero();
+            columns[1][0] = cx * point[2];
+            columns[1][1] = sx * point[2];
+            columns[1][2] = -sx * point[1] - cx * point[0];
+            return 2;
+        }
+    }
+    return 0;
+}
+
+template <int Lanes>
+LaneKernel<Lanes>::LaneKernel(const Chain& chain):
+m_chain(chain),
+m_params(chain.getNumOfConstraints(), Lane::Zero()),
+m_jacobian(3 * chain.getNumOfConstraints(), Lane::Zero()),
+m_step(chain.getNumOfConstraints(), Lane::Zero()),
+m_savedParams(chain.getNumOfConstraints(), Lane::Zero()),
+m_frames(chain.getNumOfJoints() + 1)
+{
+    for (int lane = 0; lane < Lanes; ++lane)
+        setParams(lane, chain.getParams());
+
+    Frame& base = m_frames[0];
+    for (int r = 0; r < 3; ++r) {
+        base.origin[r].setZero();
+        for (int c = 0; c < 3; ++c)
+            base.rotation[r][c].setConstant(r == c ? 1 : 0);
+    }
+}
+
+template <int Lanes>
+void
+LaneKernel<Lanes>::setParams(int lane, const float* params)
+{
+    for (size_t i = 0; i < m_params.size(); ++i)
+        m_params[i](lane) = params[i];
+}
+
+template <int Lanes>
+void
+LaneKernel<Lanes>::getParams(int lane, float* params) const
+{
+    for (size_t i = 0; i < m_params.size(); ++i)
+        params[i] = m_params[i](lane);
+}
+
+template <int Lanes>
+void
+LaneKernel<Lanes>::updateFrames(void)
+{
+    for (int i = 0; i < m_chain.getNumOfJoints(); ++i) {
+        const Frame& inboard = m_frames[i];
+        Frame& outboard = m_frames[i + 1];
+
+        Lane rotation[3][3], offset[3];
+        localTransform(m_chain.getType(i), &m_params[m_chain.getOffset(i)], rotation, offset);
+        float length = m_chain.getLength(i);
+
+        for (int r = 0; r < 3; ++r) {
+            Lane local[3];
+            for (int k = 0; k < 3; ++k)
+                local[k] = offset[k] + rotation[k][0] * length;
+            outboard.origin[r] = inboard.origin[r] + inboard.rotation[r][0] * local[0] +
+                                 inboard.rotation[r][1] * local[1] +
+                                 inboard.rotation[r][2] * local[2];
+            for (int c = 0; c < 3; ++c)
+                outboard.rotation[r][c] = inboard.rotation[r][0] * rotation[0][c] +
+                                          inboard.rotation[r][1] * rotation[1][c] +
+                                          inboard.rotation[r][2] * rotation[2][c];
+        }
+    }
+}
+
+template <int Lanes>
+void
+LaneKernel<Lanes>::updateJacobian(void)
+{
+    const Lane* tip = m_frames[m_chain.getNumOfJoints()].origin;
+
+    for (int i = 0; i < m_chain.getNumOfJoints(); ++i) {
+        const Frame& frame = m_frames[i];
+        Lane delta[3], point[3];
+        for (int r = 0; r < 3; ++r)
+            delta[r] = tip[r] - frame.origin[r];
+        for (int c = 0; c < 3; ++c)
+            point[c] = frame.rotation[0][c] * delta[0] + frame.rotation[1][c] * delta[1] +
+                       frame.rotation[2][c] * delta[2];
+
+        Lane columns[3][3];
+        int offset = m_chain.getOffset(i);
+        int dof = localJacobian(m_chain.getType(i), &m_params[offset], point, columns);
+
+        for (int j = 0; j < dof; ++j) {
+            for (int r = 0; r < 3; ++r)
+                m_jacobian[3 * (offset + j) + r] = frame.rotation[r][0] * columns[j][0] +
+                                                   frame.rotation[r][1] * columns[j][1] +
+                                                   frame.rotation[r][2] * columns[j][2];
+        }
+    }
+}
+
+template <int Lanes>
+void
+LaneKernel<Lanes>::solveDamped(const Lane* deltaP, const Lane& lambda)
+{
+    //step = J^T (JJ^T + lambda^2 I)^-1 deltaP, with the 3x3 system inverted
+    //through its adjugate
+    int n = m_params.size();
+    Lane a[3][3];
+    for (int r = 0; r < 3; ++r)
+        for (int c = r; c < 3; ++c)
+            a[r][c].setZero();
+    for (int k = 0; k < n; ++k) {
+        const Lane* column = &m_jacobian[3 * k];
+        for (int r = 0; r < 3; ++r)
+            for (int c = r; c < 3; ++c)
+                a[r][c] += column[r] * column[c];
+    }
+    for (int r = 0; r < 3; ++r) {
+        a[r][r] += lambda * lambda;
+        for (int c = 0; c < r; ++c)
+            a[r][c] = a[c][r];
+    }
+
+    Lane adjugate[3][3];
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            int r1 = (c + 1) % 3, r2 = (c + 2) % 3;
+            int c1 = (r + 1) % 3, c2 = (r + 2) % 3;
+            adjugate[r][c] = a[r1][c1] * a[r2][c2] - a[r1][c2] * a[r2][c1];
+        }
+    }
+    Lane determinant = a[0][0] * adjugate[0][0] + a[0][1] * adjugate[1][0] +
+                       a[0][2] * adjugate[2][0];
+    Lane inverse = determinant.inverse();
+
+    Lane y[3];
+    for (int r = 0; r < 3; ++r)
+        y[r] = (adjugate[r][0] * deltaP[0] + adjugate[r][1] * deltaP[1] +
+                adjugate[r][2] * deltaP[2]) * inverse;
+
+    for (int k = 0; k < n; ++k) {
+        const Lane* column = &m_jacobian[3 * k];
+        m_step[k] = column[0] * y[0] + column[1] * y[1] + column[2] * y[2];
+    }
+}
+
+template <int Lanes>
+void
+LaneKernel<Lanes>::applyStep(const Lane& strength)
+{
+    for (int i = 0; i < m_chain.getNumOfJoints(); ++i) {
+        for (int k = m_chain.getOffset(i); k < m_chain.getOffset(i + 1); ++k) {
+            Lane value = m_params[k] + m_step[k] * strength;
+            if (m_chain.getType(i) == PRISM_JOINT)
+                m_params[k] = (value >= 0).select(value, m_params[k]);
+            else
+                m_params[k] = value;
+        }
+    }
+}
+
+template <int Lanes>
+void
+LaneKernel<Lanes>::solve(const Eigen::Vector3f* goals, float lambda, SolveResult* results)
+{
+    typedef Eigen::Array<bool, Lanes, 1> Mask;
+
+    Lane goal[3], target[3];
+    for (int lane = 0; lane < Lanes; ++lane)
+        for (int r = 0; r < 3; ++r)
+            goal[r](lane) = goals[lane](r);
+
+    //Steps aim at the goal pulled back inside the chain's reach, as in
+    //ChainSolver::approachPoint, while errors are measured to the goal itself
+    Lane norm = (goal[0].square() + goal[1].square() + goal[2].square()).sqrt();
+    Lane scale = Lane::Ones();
+    if (!m_chain.isExtensible())
+        scale = (norm > m_chain.getReach()).select(m_chain.getReach() / norm, scale);
+    for (int r = 0; r < 3; ++r)
+        target[r] = goal[r] * scale;
+
+    const Lane* tip = m_frames[m_chain.getNumOfJoints()].origin;
+    updateFrames();
+
+    Lane prevError = Lane::Constant(1000);
+    Lane currError = (goal[0] - tip[0]).square() + (goal[1] - tip[1]).square() +
+                     (goal[2] - tip[2]).square();
+    Lane strength = Lane::Ones();
+    Lane damping = Lane::Constant(lambda);
+    Eigen::Array<int, Lanes, 1> iterations = Eigen::Array<int, Lanes, 1>::Zero();
+
+    for (;;) {
+        Mask active = (currError > CONVERGED_ERROR) &&
+                      ((prevError - currError).abs() > STALLED_PROGRESS);
+        if (!active.any())
+            break;
+
+        prevError = active.select(currError, prevError);
+
+        updateJacobian();
+        Lane deltaP[3];
+        for (int r = 0; r < 3; ++r)
+            deltaP[r] = target[r] - tip[r];
+        Lane startError = deltaP[0].square() + deltaP[1].square() + deltaP[2].square();
+        m_savedParams = m_params;
+
+        //ChainSolver::approachDamped per lane: lanes whose step fails are
+        //rolled back and retried with stiffer damping while the rest wait
+        Mask pending = active;
+        for (int attempt = 0; attempt < MAX_DAMPING_ATTEMPTS && pending.any(); ++attempt) {
+            solveDamped(deltaP, damping);
+            applyStep(pending.select(strength, Lane::Zero()));
+
+            updateFrames();
+            Lane error = (target[0] - tip[0]).square() + (target[1] - tip[1]).square() +
+                         (target[2] - tip[2]).square();
+            Mask accepted = pending && error < startError;
+            Mask rejected = pending && error >= startError;
+
+            damping = accepted.select((damping * 0.5f).max(Lane::Constant(ChainSolver::MIN_DAMPING)),
+                                      damping);
+            for (size_t k = 0; k < m_params.size(); ++k)
+                m_params[k] = rejected.select(m_savedParams[k], m_params[k]);
+
+            pending = rejected && damping < ChainSolver::MAX_DAMPING;
+            damping = pending.select((damping * 4.0f).min(Lane::Constant(ChainSolver::MAX_DAMPING)),
+                                     damping);
+        }
+
+        updateFrames();
+        currError = (goal[0] - tip[0]).square() + (goal[1] - tip[1]).square() +
+                    (goal[2] - tip[2]).square();
+        strength = (active && currError > prevError).select(strength * 0.5f, strength);
+        iterations += active.template cast<int>();
+    }
+
+    for (int lane = 0; lane < Lanes; ++lane) {
+        results[lane].converged = currError(lane) <= CONVERGED_ERROR;
+        results[lane].exhausted = false;
+        results[lane].iterations = iterations(lane);
+        results[lane].error = currError(lane);
+    }
+}
+
+template <int Lanes>
+void
+solveBatchLanes(const Chain& chain, const float* start,
+                const Eigen::Vector3f* targets, int count, const float* seeds,
+                float lambda, float* solutions, SolveResult* results)
+{
+    int n = chain.getNumOfConstraints();
+    LaneKernel<Lanes>* kernel = new LaneKernel<Lanes>(chain);
+
+    for (int first = 0; first < count; first += Lanes) {
+        Eigen::Vector3f goals[Lanes];
+        SolveResult laneResults[Lanes];
+
+        for (int lane = 0; lane < Lanes; ++lane) {
+            int i = std::min(first + lane, count - 1);
+            goals[lane] = targets[i];
+            kernel->setParams(lane, seeds ? seeds + i * n : start);
+        }
+
+        kernel->solve(goals, lambda, laneResults);
+
+        for (int lane = 0; lane < Lanes && first + lane < count; ++lane) {
+            results[first + lane] = laneResults[lane];
+            kernel->getParams(lane, solutions + (first + lane) * n);
+        }
+    }
+
+    delete kernel;
+}
+
+template class LaneKernel<4>;
+template class LaneKernel<8>;
+
+template void solveBatchLanes<4>(const Chain&, const float*, const Eigen::Vector3f*, int,
+                                 const float*, float, float*, SolveResult*);
+template void solveBatchLanes<8>(const Chain&, const float*, const Eigen::Vector3f*, int,
+                                 const float*, float, float*, SolveResult*);
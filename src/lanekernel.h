@@ -0,0 +1,69 @@
+#ifndef __incl_lanekernel__
+#define __incl_lanekernel__
+
+#include <vector>
+
+#include <Eigen/StdVector>
+
+#include "chain.h"
+#include "chainsolver.h"
+
+//Solves Lanes copies of one chain shape in lockstep. Every scalar of the
+//solver (a joint parameter, one entry of a frame, of the Jacobian or of the
+//3x3 damped system) is an Eigen array holding that value for all lanes, so
+//forward kinematics, Jacobian assembly and the damped least-squares step run
+//once per chain instead of once per arm, with each operation vectorized
+//across the arms. The lanes share types and lengths but not parameters or
+//goals; a lane that has converged keeps running but its steps are masked out.
+template <int Lanes>
+class LaneKernel
+{
+public:
+    typedef Eigen::Array<float, Lanes, 1> Lane;
+
+    //Base-frame inboard frame of one joint, for every lane
+    struct Frame
+    {
+        Lane rotation[3][3];
+        Lane origin[3];
+    };
+
+private:
+    typedef std::vector<Lane, Eigen::aligned_allocator<Lane> > LaneArray;
+    typedef std::vector<Frame, Eigen::aligned_allocator<Frame> > Frames;
+
+    const Chain& m_chain;
+    LaneArray m_params;
+    LaneArray m_jacobian; //3 rows per constraint, column-major
+    LaneArray m_step;
+    LaneArray m_savedParams;
+    Frames m_frames;
+
+    void updateFrames(void);
+    void updateJacobian(void);
+    void solveDamped(const Lane* deltaP, const Lane& lambda);
+    void applyStep(const Lane& strength);
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    //Lanes of chain's shape, each starting at chain's current parameters.
+    //chain must outlive the kernel.
+    LaneKernel(const Chain& chain);
+
+    void setParams(int lane, const float* params);
+    void getParams(int lane, float* params) const;
+
+    //Runs ChainSolver::solve in DLS_SOLVER mode for every lane at once, each
+    //lane adapting its own damping from lambda, and writes one result per lane
+    void solve(const Eigen::Vector3f* goals, float lambda, SolveResult* results);
+};
+
+//ChainSolver::solveBatch in DLS_SOLVER mode, Lanes targets per pass. The last pass is
+//padded by repeating its final target.
+template <int Lanes>
+void solveBatchLanes(const Chain& chain, const float* start,
+                     const Eigen::Vector3f* targets, int count, const float* seeds,
+                     float lambda, float* solutions, SolveResult* results);
+
+#endif
@@ -0,0 +1,87 @@
+#include <algorithm>
+
+#include "lookahead.h"
+
+LookAheadSolver::LookAheadSolver(Arm& arm, const Path& path, int capacity, bool warmStart,
+                                 float stepDegrees):
+m_chain(arm.getChain()),
+m_solver(&m_chain, arm.getSolver()),
+m_path(path),
+m_tracker(&m_solver, warmStart, stepDegrees)
+{
+    m_ring.resize(std::max(capacity, 1));
+    for (size_t i = 0; i < m_ring.size(); ++i)
+        m_ring[i].params.resize(m_chain.getNumOfConstraints());
+    m_head = 0;
+    m_count = 0;
+    m_stopping = false;
+
+    m_solver.setTelemetry(&m_telemetry);
+    m_thread = std::thread(&LookAheadSolver::run, this);
+}
+
+LookAheadSolver::~LookAheadSolver(void)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stopping = true;
+    }
+    m_notFull.notify_all();
+    m_thread.join();
+}
+
+void
+LookAheadSolver::run(void)
+{
+    int size = m_ring.size();
+    for (;;) {
+        //Solving happens outside the lock; only the copy into the ring is
+        //shared with the consumer
+        SolveResult result = m_tracker.update(m_path);
+
+        std::unique_lock<std::mutex> guard(m_lock);
+        while (!m_stopping && m_count == size)
+            m_notFull.wait(guard);
+        if (m_stopping)
+            return;
+
+        LookAheadFrame& frame = m_ring[(m_head + m_count) % size];
+        std::copy(m_chain.getParams(), m_chain.getParams() + m_chain.getNumOfConstraints(),
+                  frame.params.begin());
+        frame.result = result;
+        frame.telemetry = m_telemetry;
+        m_count++;
+        m_notEmpty.notify_one();
+    }
+}
+
+bool
+LookAheadSolver::pop(LookAheadFrame& frame, bool wait)
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+    if (!wait && m_count == 0)
+        return false;
+    while (m_count == 0)
+        m_notEmpty.wait(guard);
+
+    //Swapping hands the ring slot the caller's old storage, so neither side
+    //allocates once both have seen a full frame
+    LookAheadFrame& front = m_ring[m_head];
+    frame.params.swap(front.params);
+    frame.params.resize(m_chain.getNumOfConstraints());
+    front.params.resize(m_chain.getNumOfConstraints());
+    frame.result = front.result;
+    std::swap(frame.telemetry, front.telemetry);
+
+    m_head = (m_head + 1) % m_ring.size();
+    m_count--;
+    m_notFull.notify_one();
+    return true;
+}
+
+int
+LookAheadSolver::getNumOfReady(void)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_count;
+}
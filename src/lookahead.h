@@ -0,0 +1,61 @@
+#ifndef __incl_lookahead__
+#define __incl_lookahead__
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "arm.h"
+#include "tracker.h"
+
+//One pre-solved update: the pose for the path's next point
+struct LookAheadFrame
+{
+    std::vector<float> params;
+    SolveResult result;
+    SolveTelemetry telemetry;
+};
+
+//Solves the upcoming points of a path on a background thread. Paths are
+//deterministic, so the thread runs its own copies of the arm's chain, solver
+//and path ahead of the consumer and keeps up to capacity finished frames in
+//a ring buffer; the consumer takes them in order and never waits on a solve
+//unless it asks to. The arm is only read when the solver is constructed.
+class LookAheadSolver
+{
+    Chain m_chain;
+    ChainSolver m_solver;
+    Path m_path;
+    PathTracker m_tracker;
+    SolveTelemetry m_telemetry;
+
+    std::vector<LookAheadFrame> m_ring;
+    int m_head; //Oldest finished frame
+    int m_count;
+    bool m_stopping;
+    std::mutex m_lock;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::thread m_thread;
+
+    void run(void);
+
+    LookAheadSolver(const LookAheadSolver&);
+    LookAheadSolver& operator=(const LookAheadSolver&);
+
+public:
+    //Starts solving right away from the arm's current pose and settings,
+    //following a copy of path from its current point
+    LookAheadSolver(Arm& arm, const Path& path, int capacity, bool warmStart,
+                    float stepDegrees = 1.5f);
+    ~LookAheadSolver(void);
+
+    //Moves the next frame into frame. Returns false if none is ready and
+    //wait is false; otherwise blocks until one is.
+    bool pop(LookAheadFrame& frame, bool wait);
+
+    int getNumOfReady(void);
+};
+
+#endif
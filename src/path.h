@@ -52,8 +52,6 @@ public:
         if (degree >= 360) degree -= 360;
     }
 
-    virtual void render(void);
-
     virtual void print() { //Debugging purposes, can remove later
         std::cout << "Path:\n";
         std::cout << "Coefficients: a = " << a << ", b = " << b << std::endl;
@@ -0,0 +1,20 @@
+#include "posebuffer.h"
+
+void
+PoseSnapshot::interpolate(const Chain& chain, float interpolation,
+                          std::vector<float>& result) const
+{
+    result.resize(params.size());
+    if (!params.empty())
+        chain.interpolate(&previousParams[0], &params[0], interpolation, &result[0]);
+}
+
+float
+PoseSnapshot::getDegree(float interpolation) const
+{
+    //The path degree wraps at 360
+    float delta = path.getDegree() - previousDegree;
+    if (delta < 0)
+        delta += 360;
+    return previousDegree + delta * interpolation;
+}
@@ -0,0 +1,67 @@
+#ifndef __incl_posebuffer__
+#define __incl_posebuffer__
+
+#include <atomic>
+#include <vector>
+
+#include "chain.h"
+#include "path.h"
+
+//Everything needed to draw one solved update: the pose before and after it
+//and the path as it stood afterwards
+struct PoseSnapshot
+{
+    std::vector<float> params;
+    std::vector<float> previousParams;
+    Path path;
+    float previousDegree;
+    int frame;
+
+    //Joint parameters and path degree at interpolation of the way from the
+    //previous pose to this one, for a chain of the snapshot's shape
+    void interpolate(const Chain& chain, float interpolation, std::vector<float>& result) const;
+    float getDegree(float interpolation) const;
+};
+
+//Hands the latest snapshot from one writer thread to one reader thread
+//without locks. Three slots rotate through an atomic index: the writer fills
+//its own slot and swaps it for the shared one, the reader swaps its slot for
+//the shared one only when a newer snapshot has been published. Neither side
+//ever waits, copies another's slot or sees a half written snapshot;
+//snapshots published between two reads are skipped.
+class PoseBuffer
+{
+    enum { FRESH = 4, INDEX = 3 };
+
+    PoseSnapshot m_slots[3];
+    std::atomic<int> m_shared; //Slot index, plus FRESH if not read yet
+    int m_writing;
+    int m_reading;
+
+    PoseBuffer(const PoseBuffer&);
+    PoseBuffer& operator=(const PoseBuffer&);
+
+public:
+    PoseBuffer(void):
+    m_shared(1),
+    m_writing(0),
+    m_reading(2) {}
+
+    //Writer side: fill the slot returned here, then publish it
+    PoseSnapshot& edit(void) {
+        return m_slots[m_writing];
+    }
+
+    void publish(void) {
+        m_writing = m_shared.exchange(m_writing | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    //Reader side: the newest published snapshot, valid until the next call
+    const PoseSnapshot& read(void) {
+        if (m_shared.load(std::memory_order_relaxed) & FRESH)
+            m_reading = m_shared.exchange(m_reading, std::memory_order_acq_rel) & INDEX;
+        return m_slots[m_reading];
+    }
+};
+
+#endif
@@ -0,0 +1,27 @@
+#include "predictor.h"
+
+void
+PosePredictor::reset(int numOfConstraints)
+{
+    m_previous.resize(numOfConstraints);
+    m_current.resize(numOfConstraints);
+    m_prediction.resize(numOfConstraints);
+    m_numOfRecorded = 0;
+}
+
+void
+PosePredictor::record(const float* params)
+{
+    m_previous.swap(m_current);
+    m_current = Eigen::Map<const Eigen::VectorXf>(params, m_current.size());
+    m_numOfRecorded++;
+}
+
+const float*
+PosePredictor::predict(void)
+{
+    if (m_numOfRecorded < 2)
+        return NULL;
+    m_prediction = 2 * m_current - m_previous;
+    return m_prediction.data();
+}
@@ -0,0 +1,30 @@
+#ifndef __incl_predictor__
+#define __incl_predictor__
+
+#include <Eigen/Dense>
+
+//Guesses the next solution of a chain tracking a smoothly moving goal by
+//extrapolating the last two solutions at constant joint velocity
+class PosePredictor
+{
+    Eigen::VectorXf m_previous;
+    Eigen::VectorXf m_current;
+    Eigen::VectorXf m_prediction;
+    int m_numOfRecorded;
+
+public:
+    PosePredictor(void) {
+        m_numOfRecorded = 0;
+    }
+
+    //Forgets the history; poses have numOfConstraints parameters
+    void reset(int numOfConstraints);
+
+    //Adds the solution of the latest frame
+    void record(const float* params);
+
+    //Extrapolated next solution, or NULL until two solutions are recorded
+    const float* predict(void);
+};
+
+#endif
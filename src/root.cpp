@@ -6,28 +6,12 @@
 #include <list>
 #include "assert.h"
 
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <sys/time.h>
-#endif
-
-#ifdef __APPLE__
-#include <GLUT/glut.h>
-#include <OpenGL/gl.h>
-#include <OpenGL/glu.h>
-#else
-#include <GL/glut.h>
-#include <GL/glu.h>
-#endif
-
 #ifndef DEBUG
 #define NDEBUG
 #endif
 
 #define MAX_LINE_LENGTH 1000
-#define DEFAULT_WIDTH 720
-#define DEFAULT_HEIGHT 720
+#define PATH_STEP_DEGREES 1.5f
 
 void
 Root::init(int argc, char** argv, FILE* input)
@@ -37,13 +21,23 @@ Root::init(int argc, char** argv, FILE* input)
     m_pCameraPath = new Path();
     m_maxSize = 0;
 
+    m_frame = 0;
+    m_warmStart = true;
+    m_lookAheadFrames = 0;
+    m_updateRate = 24;
+    m_renderRate = 60;
+
     parse(input);
     m_maxSize *= 1.15;
-
-    glutInit(&argc, argv);
-    glutInitDisplayMode(GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGB);
-    glutInitWindowSize(DEFAULT_WIDTH, DEFAULT_HEIGHT);
-    glutInitWindowPosition(0,0);
+    m_publishedParams.assign(m_pArm->getChain().getParams(),
+                             m_pArm->getChain().getParams() + m_pArm->getChain().getNumOfConstraints());
+    m_publishedDegree = m_pArmPath->getDegree();
+    publishPose();
+    m_pArm->getSolver().setTelemetry(&m_telemetry);
+    m_pTracker = new PathTracker(&m_pArm->getSolver(), m_warmStart, PATH_STEP_DEGREES);
+    if (m_lookAheadFrames > 0)
+        m_pLookAhead = new LookAheadSolver(*m_pArm, *m_pArmPath, m_lookAheadFrames, m_warmStart,
+                                           PATH_STEP_DEGREES);
 
     m_isInitialized = true;
     return;
@@ -51,7 +45,7 @@ Root::init(int argc, char** argv, FILE* input)
 
 void
 Root::parse(FILE* input) {
-    const char* flags[] = {"-mod", "-arm", "-path", "-cir", "-ell"};
+    const char* flags[] = {"-mod", "-arm", "-path", "-cir", "-ell", "-solver", "-telemetry", "-budget", "-warmstart", "-lookahead", "-rate", "-broyden"};
     char lineBuffer[MAX_LINE_LENGTH];
     char* token = NULL;
     int mode = 0;
@@ -82,7 +76,8 @@ Root::parse(FILE* input) {
 
             std::list<char*>::iterator iter;
             int counter;
-            float a, b, rad, x, y;
+            float a, b, rad, x, y, damping, maxStep;
+            TelemetryFormat format;
 
             switch(mode) {
                 case 0: //-mod input.obj
@@ -188,6 +183,131 @@ Root::parse(FILE* input) {
                     m_pArmPath->setRad(x, y);
                     m_maxSize = std::max(m_maxSize, std::max(x, y));
                     break;
+                case 5: //-solver pinv | dls [damping] | sdls [max step] | fabrik | ccd |
+                        //hybrid [fabrik | ccd] [radius] [stall ratio] [dls | fabrik | ccd]
+                    iter = args.begin();
+                    if (iter == args.end()) {
+                        std::cout << "Error parsing -solver" << std::endl;
+                        break;
+                    }
+                    if (!strcmp(*iter, "pinv")) {
+                        m_pArm->getSolver().setMode(PSEUDOINVERSE_SOLVER);
+                    } else if (!strcmp(*iter, "dls")) {
+                        m_pArm->getSolver().setMode(DLS_SOLVER);
+                        if (++iter != args.end()) {
+                            damping = std::atof(*iter);
+                            if (damping > 0)
+                                m_pArm->getSolver().setDamping(damping);
+                            else
+                                std::cout << "Error parsing -solver dls" << std::endl;
+                        }
+                    } else if (!strcmp(*iter, "fabrik")) {
+                        m_pArm->getSolver().setMode(FABRIK_SOLVER);
+                    } else if (!strcmp(*iter, "ccd")) {
+                        m_pArm->getSolver().setMode(CCD_SOLVER);
+                    } else if (!strcmp(*iter, "hybrid")) {
+                        HybridPolicy policy;
+                        if (++iter != args.end()) {
+                            if (!strcmp(*iter, "ccd"))
+                                policy = HybridPolicy(CCD_SOLVER);
+                            else if (strcmp(*iter, "fabrik"))
+                                std::cout << "Error parsing -solver hybrid" << std::endl;
+                        }
+                        if (iter != args.end() && ++iter != args.end())
+                            policy.radius = std::atof(*iter);
+                        if (iter != args.end() && ++iter != args.end())
+                            policy.stallRatio = std::atof(*iter);
+                        if (iter != args.end() && ++iter != args.end()) {
+                            if (!strcmp(*iter, "dls"))
+                                policy.stallMode = DLS_SOLVER;
+                            else if (!strcmp(*iter, "fabrik"))
+                                policy.stallMode = FABRIK_SOLVER;
+                            else if (!strcmp(*iter, "ccd"))
+                                policy.stallMode = CCD_SOLVER;
+                            else
+                                std::cout << "Error parsing -solver hybrid" << std::endl;
+                        }
+                        if (policy.radius < 0 || policy.stallRatio <= 0) {
+                            std::cout << "Error parsing -solver hybrid" << std::endl;
+                            policy = HybridPolicy();
+                        }
+                        m_pArm->getSolver().setMode(HYBRID_SOLVER);
+                        m_pArm->getSolver().setHybridPolicy(policy);
+                    } else if (!strcmp(*iter, "sdls")) {
+                        m_pArm->getSolver().setMode(SDLS_SOLVER);
+                        if (++iter != args.end()) {
+                            maxStep = std::atof(*iter);
+                            if (maxStep > 0)
+                                m_pArm->getSolver().setMaxStep(maxStep);
+                            else
+                                std::cout << "Error parsing -solver sdls" << std::endl;
+                        }
+                    } else {
+                        std::cout << "Unknown solver ignored: " << *iter << std::endl;
+                    }
+                    break;
+                case 6: //-telemetry file [csv | json]
+                    iter = args.begin();
+                    if (iter == args.end()) {
+                        std::cout << "Error parsing -telemetry" << std::endl;
+                        break;
+                    }
+                    format = CSV_TELEMETRY;
+                    if (args.size() > 1 && !strcmp(args.back(), "json"))
+                        format = JSON_TELEMETRY;
+                    if (!m_telemetryLog.open(*iter, format))
+                        std::cout << "Unable to open telemetry log " << *iter << std::endl;
+                    break;
+                case 7: //-budget iterations [milliseconds]
+                    iter = args.begin();
+                    if (iter == args.end()) {
+                        std::cout << "Error parsing -budget" << std::endl;
+                        break;
+                    }
+                    counter = std::atoi(*iter);
+                    x = ++iter != args.end() ? std::atof(*iter) : 0;
+                    if (counter < 0 || x < 0) {
+                        std::cout << "Error parsing -budget" << std::endl;
+                        break;
+                    }
+                    m_pArm->getSolver().setBudget(SolveBudget(counter, x / 1000.0));
+                    break;
+                case 8: //-warmstart on | off
+                    iter = args.begin();
+                    if (iter != args.end() && !strcmp(*iter, "off"))
+                        m_warmStart = false;
+                    else if (iter != args.end() && !strcmp(*iter, "on"))
+                        m_warmStart = true;
+                    else
+                        std::cout << "Error parsing -warmstart" << std::endl;
+                    break;
+                case 9: //-lookahead frames
+                    iter = args.begin();
+                    counter = iter != args.end() ? std::atoi(*iter) : 0;
+                    if (counter > 0)
+                        m_lookAheadFrames = counter;
+                    else
+                        std::cout << "Error parsing -lookahead" << std::endl;
+                    break;
+                case 10: //-rate updates [renders]
+                    iter = args.begin();
+                    x = iter != args.end() ? std::atof(*iter++) : 0;
+                    y = iter != args.end() ? std::atof(*iter) : m_renderRate;
+                    if (x > 0 && y > 0) {
+                        m_updateRate = x;
+                        m_renderRate = y;
+                    } else {
+                        std::cout << "Error parsing -rate" << std::endl;
+                    }
+                    break;
+                case 11: //-broyden refresh
+                    iter = args.begin();
+                    counter = iter != args.end() ? std::atoi(*iter) : 0;
+                    if (counter > 0)
+                        m_pArm->getSolver().setJacobianRefresh(counter);
+                    else
+                        std::cout << "Error parsing -broyden" << std::endl;
+                    break;
                 default:
                     break;
             }
@@ -196,169 +316,76 @@ Root::parse(FILE* input) {
     return;
 }
 
-void
-Root::run(void (*render)(void),
-          void (*reshape)(int, int),
-          void (*idle)(void),
-          void (*input)(unsigned char, int, int)) {
-    assert(m_isInitialized);
-    m_pArm->print();
-    m_pArmPath->print();
-
-    glutCreateWindow("root");
-    glutDisplayFunc(render);
-    glutReshapeFunc(reshape);
-    glutIdleFunc(idle);
-    glutKeyboardFunc(input);
-
-    glMatrixMode(GL_MODELVIEW);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    glLoadIdentity();
-
-    glDepthFunc(GL_LEQUAL);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_NORMALIZE);
-
-    glOrtho(-m_maxSize, m_maxSize, -m_maxSize, m_maxSize, m_maxSize, -m_maxSize);
-
-    //Lighting
-    GLfloat position0[] = {5.0, 5.0, 0.0, 1.0};
-    GLfloat ambient0[] = {0.5, 1.0, 1.0, 1.0};
-    GLfloat diffuse0[] = {1.0, 0.1, 0.3, 1.0};
-    GLfloat specular0[] = {0.1, 0.1, 0.1, 1.0};
-    glLightfv(GL_LIGHT0, GL_POSITION, position0);
-    glLightfv(GL_LIGHT0, GL_AMBIENT, ambient0);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse0);
-    glLightfv(GL_LIGHT0, GL_SPECULAR, specular0);
-
-    //Lighting
-    GLfloat position1[] = {-5.0, -5.0, 0.0, 1.0};
-    GLfloat ambient1[] = {0.0, 0.0, 0.3, 1.0};
-    GLfloat diffuse1[] = {0.05, 0.2, 0.8, 1.0};
-    GLfloat specular1[] = {0.05, 0.1, 0.1, 1.0};
-    glLightfv(GL_LIGHT1, GL_POSITION, position1);
-    glLightfv(GL_LIGHT1, GL_AMBIENT, ambient1);
-    glLightfv(GL_LIGHT1, GL_DIFFUSE, diffuse1);
-    glLightfv(GL_LIGHT1, GL_SPECULAR, specular1);
-
-    GLfloat position2[] = {-5.0, 0.0, 0.0, 1.0};
-    GLfloat ambient2[] = {0.0, 0.3, 0.0, 1.0};
-    GLfloat diffuse2[] = {0.05, 0.8, 0.2, 1.0};
-    GLfloat specular2[] = {0.1, 0.2, 0.1, 1.0};
-    glLightfv(GL_LIGHT2, GL_POSITION, position2);
-    glLightfv(GL_LIGHT2, GL_AMBIENT, ambient2);
-    glLightfv(GL_LIGHT2, GL_DIFFUSE, diffuse2);
-    glLightfv(GL_LIGHT2, GL_SPECULAR, specular2);
-
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_LIGHT1);
-    glEnable(GL_LIGHT2);
-
-    m_updateClock = clock();
-    m_renderClock = clock();
+SolveResult
+Root::update(void)
+{
+    if (m_pLookAhead) {
+        m_pLookAhead->pop(m_lookAheadFrame, true);
+        return applyLookAheadFrame();
+    }
 
-    glColor3f(rand()/(float)RAND_MAX, rand()/(float)RAND_MAX, rand()/(float)RAND_MAX);
-    glutMainLoop();
+    SolveResult result = m_pTracker->update(*m_pArmPath);
+    m_telemetryLog.write(m_frame++, m_telemetry);
+    publishPose();
+    return result;
 }
 
-float absDifference(float a, float b)
+bool
+Root::poll(SolveResult& result)
 {
-    float difference = a - b;
-    if (difference < 0)
-        return -difference;
-    return difference;
+    if (!m_pLookAhead) {
+        result = update();
+        return true;
+    }
+
+    if (!m_pLookAhead->pop(m_lookAheadFrame, false))
+        return false;
+    result = applyLookAheadFrame();
+    return true;
 }
 
-void
-Root::update(void)
+SolveResult
+Root::applyLookAheadFrame(void)
 {
-    Eigen::Vector3f goalPoint = m_pArmPath->getNextPoint(1.5);
-    Eigen::Vector3f err = goalPoint - m_pArm->getEndEffector();
-    float prevError = 1000;
-    float currError = err(0) * err(0) + err(1) * err(1) + err(2) * err(2);
-
-    float b = 1;
-    while (currError > 0.0001 && absDifference(prevError, currError) > 0.000001)
-    {
-        prevError = currError;
-        m_pArm->approachPoint(goalPoint, b); 
-        err = goalPoint - m_pArm->getEndEffector(); 
-        currError = err(0) * err(0) + err(1) * err(1) + err(2) * err(2);
-        if (currError > prevError)
-            b /= 2;
-    }
+    //Keep the arm and the path where the background thread had them, so
+    //rendering and telemetry look the same as without look-ahead
+    m_pArm->setParams(&m_lookAheadFrame.params[0]);
+    m_pArmPath->addDegree(PATH_STEP_DEGREES);
+    std::swap(m_telemetry, m_lookAheadFrame.telemetry);
+    m_telemetryLog.write(m_frame++, m_telemetry);
+    publishPose();
+    return m_lookAheadFrame.result;
 }
 
 void
-Root::render(float interpolation)
+Root::publishPose(void)
 {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    glPushMatrix();
-    glTranslatef(0, -0.5, 0);
-    glRotatef(90, 1, 0, 0);
-    glRotatef(m_pArmPath->getDegree(), 0, 0, -1);
-    m_pArmPath->render();
-    m_pArm->render(interpolation);
-    glPopMatrix();
-
-    glFlush();
-    glutSwapBuffers();
-    return;
+    const Chain& chain = m_pArm->getChain();
+    PoseSnapshot& pose = m_poses.edit();
+    pose.params.assign(chain.getParams(), chain.getParams() + chain.getNumOfConstraints());
+    pose.previousParams = m_publishedParams;
+    pose.path = *m_pArmPath;
+    pose.previousDegree = m_publishedDegree;
+    pose.frame = m_frame;
+
+    m_publishedParams = pose.params;
+    m_publishedDegree = m_pArmPath->getDegree();
+    m_poses.publish();
 }
 
 void
 Root::halt(void)
 {
+    //The look-ahead thread must stop before anything it was copied from goes
+    delete m_pLookAhead;
+    delete m_pTracker;
+    m_pLookAhead = NULL;
+    m_pTracker = NULL;
+
     delete m_pArm;
     delete m_pArmPath;
     delete m_pCameraPath;
-}
-
-//---------------OpenGL Helper Functions---------------
-
-void
-Root::handleInput(unsigned char key, int x, int y) {
-    switch (key) {
-        case ' ':
-            halt();
-            exit(EXIT_SUCCESS);
-            break;
-        default:
-            break;
-    }
-    return;
-}
-
-void
-Root::render() { //OpenGL glDisplayFunc
-    return;
-}
-
-void
-Root::idle() {
-    const int UPDATE_RATE = 24;
-    const int FRAME_RATE = 60;
-
-    clock_t t = clock();
-
-    if ((t - m_updateClock)/(float)CLOCKS_PER_SEC > 1/(float)UPDATE_RATE) {
-        m_updateClock = clock();
-        update();
-    }
-
-    if ((t - m_renderClock)/(float)CLOCKS_PER_SEC > 1/(float)FRAME_RATE) {
-        m_renderClock = clock();
-        float interpolation = (t - m_updateClock)/(float)CLOCKS_PER_SEC * UPDATE_RATE;
-        render(interpolation);
-    }
-
-    return;
-}
-
-void
-Root::reshape(int width, int height) {
-    glViewport(0, 0, width, height);
-    return;
+    m_pArm = NULL;
+    m_pArmPath = NULL;
+    m_pCameraPath = NULL;
 }
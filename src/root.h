@@ -3,43 +3,93 @@
 
 #include <cstdio>
 #include <ctime>
+#include <vector>
 #include "arm.h"
 #include "path.h"
+#include "lookahead.h"
+#include "posebuffer.h"
+#include "tracker.h"
 
+//Scene built from an input file and the IK loop that tracks its path.
+//Root has no window or GL dependency; Viewer adds the GLUT front end.
 class Root
 {
+protected:
     Arm* m_pArm;
     Path* m_pArmPath;
     Path* m_pCameraPath;
 
     float m_maxSize;
     bool m_isInitialized;
-    clock_t m_updateClock;
-    clock_t m_renderClock;
+
+    SolveTelemetry m_telemetry; //Of the last update
+    TelemetryLog m_telemetryLog;
+    int m_frame;
+
+    PathTracker* m_pTracker;
+    bool m_warmStart; //Start each update from the predicted pose
+
+    //With -lookahead, updates come pre-solved from a background thread
+    LookAheadSolver* m_pLookAhead;
+    LookAheadFrame m_lookAheadFrame;
+    int m_lookAheadFrames;
+
+    //Every finished update is published here for the renderer, which may
+    //run on another thread and never touches the arm or path directly
+    PoseBuffer m_poses;
+    std::vector<float> m_publishedParams;
+    float m_publishedDegree;
+    float m_updateRate; //Per second, when run on a clock
+    float m_renderRate;
+
+    virtual void parse(FILE* input);
+    void publishPose(void);
+    SolveResult applyLookAheadFrame(void);
 
 public:
-    Root(void):m_isInitialized(false) {}
+    Root(void):
+    m_pArm(NULL),
+    m_pArmPath(NULL),
+    m_pCameraPath(NULL),
+    m_isInitialized(false),
+    m_frame(0),
+    m_pTracker(NULL),
+    m_warmStart(true),
+    m_pLookAhead(NULL),
+    m_lookAheadFrames(0),
+    m_publishedDegree(0),
+    m_updateRate(24),
+    m_renderRate(60) {}
     virtual ~Root(void) { halt(); }
 
     virtual void init(int argc, char** argv, FILE* input);
 
-    virtual void run(void (*render)(void),
-          void (*reshape)(int, int),
-          void (*idle)(void),
-          void (*input)(unsigned char, int, int));
-    virtual void update(void);
-    virtual void render(float interpolation);
+    //Advances the goal along the path and solves for it. With look-ahead
+    //the solve has usually happened already; if not, this waits for it.
+    virtual SolveResult update(void);
+
+    //Same as update() but never waits on a solve: returns false, leaving the
+    //arm and path where they are, if the next pre-solved frame is not ready
+    virtual bool poll(SolveResult& result);
 
     virtual void halt(void);
 
-    //OpenGL helper functions
-    virtual void handleInput(unsigned char key, int x, int y);
-    virtual void reshape(int width, int height);
-    virtual void idle();
-    virtual void render();
+    Arm* getArm(void) {
+        return m_pArm;
+    }
 
-protected:
-    virtual void parse(FILE* input);
+    Path* getArmPath(void) {
+        return m_pArmPath;
+    }
+
+    const SolveTelemetry& getTelemetry(void) const {
+        return m_telemetry;
+    }
+
+    //Latest published update; to be called from one thread only
+    const PoseSnapshot& getLatestPose(void) {
+        return m_poses.read();
+    }
 };
 
 #endif
@@ -0,0 +1,64 @@
+#include <algorithm>
+
+#include "scheduler.h"
+
+FixedStepScheduler::FixedStepScheduler(float updateRate, float renderRate)
+{
+    setRates(updateRate, renderRate);
+    start();
+}
+
+void
+FixedStepScheduler::setRates(float updateRate, float renderRate)
+{
+    m_updateStep = 1.0 / updateRate;
+    m_renderStep = 1.0 / renderRate;
+}
+
+void
+FixedStepScheduler::start(void)
+{
+    m_start = Clock::now();
+    m_now = 0;
+    m_nextUpdate = m_updateStep;
+    m_nextRender = 0;
+}
+
+void
+FixedStepScheduler::tick(void)
+{
+    m_now = std::chrono::duration<double>(Clock::now() - m_start).count();
+    m_nextUpdate = std::max(m_nextUpdate, m_now - MAX_PENDING_UPDATES * m_updateStep);
+}
+
+bool
+FixedStepScheduler::takeRender(void)
+{
+    if (m_now < m_nextRender)
+        return false;
+
+    //Renders that were missed are skipped rather than made up
+    m_nextRender += m_renderStep;
+    if (m_nextRender <= m_now)
+        m_nextRender = m_now + m_renderStep;
+    return true;
+}
+
+float
+FixedStepScheduler::getInterpolation(void) const
+{
+    double elapsed = m_now - (m_nextUpdate - m_updateStep);
+    return std::min(std::max(elapsed / m_updateStep, 0.0), 1.0);
+}
+
+double
+FixedStepScheduler::getIdleTime(void) const
+{
+    return std::max(std::min(m_nextUpdate, m_nextRender) - m_now, 0.0);
+}
+
+double
+FixedStepScheduler::getRenderIdleTime(void) const
+{
+    return std::max(m_nextRender - m_now, 0.0);
+}
@@ -0,0 +1,58 @@
+#ifndef __incl_scheduler__
+#define __incl_scheduler__
+
+#include <chrono>
+
+//Fixed timestep loop driven by a monotonic wall clock. Updates are due at
+//exact multiples of the update step no matter how long each one took;
+//renders are paced separately and are told how far the clock has moved
+//past the last update, so they can interpolate between solved poses.
+class FixedStepScheduler
+{
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point m_start;
+    double m_now; //Seconds since start(), as of the last tick()
+    double m_updateStep;
+    double m_renderStep;
+    double m_nextUpdate;
+    double m_nextRender;
+
+public:
+    //Updates falling further behind than this are dropped, so a slow frame
+    //does not make the loop spend ever longer catching up
+    static const int MAX_PENDING_UPDATES = 5;
+
+    FixedStepScheduler(float updateRate = 24, float renderRate = 60);
+
+    //Updates and renders per second
+    void setRates(float updateRate, float renderRate);
+
+    void start(void);
+
+    //Reads the clock; everything below works on the time of the last tick
+    void tick(void);
+
+    bool isUpdateDue(void) const {
+        return m_now >= m_nextUpdate;
+    }
+
+    //Marks the oldest due update as done
+    void consumeUpdate(void) {
+        m_nextUpdate += m_updateStep;
+    }
+
+    //True once per render step
+    bool takeRender(void);
+
+    //Fraction of an update step since the last consumed update, in [0, 1]
+    float getInterpolation(void) const;
+
+    //Seconds until an update or a render is next due, 0 if one already is
+    double getIdleTime(void) const;
+
+    //Seconds until a render is next due, 0 if one already is
+    double getRenderIdleTime(void) const;
+};
+
+#endif
@@ -0,0 +1,10 @@
+#include "solver.h"
+
+void
+SolverWorkspace::resize(int numOfConstraints)
+{
+    jacobian.resize(3, numOfConstraints);
+    deltaTheta.resize(numOfConstraints);
+    svd = Eigen::JacobiSVD<Eigen::MatrixXf>(3, numOfConstraints,
+                                            Eigen::ComputeThinU | Eigen::ComputeThinV);
+}
@@ -0,0 +1,172 @@
+#ifndef __incl_solver__
+#define __incl_solver__
+
+#include <Eigen/Dense>
+#include <Eigen/SVD>
+#include <algorithm>
+#include <cmath>
+
+#define SINGULAR_EPSILON 1e-6f
+
+//Strategy used by Arm::approachPoint to turn an end effector error into a
+//joint update
+enum SolverMode
+{
+    PSEUDOINVERSE_SOLVER,
+    DLS_SOLVER,
+    SDLS_SOLVER,
+    FABRIK_SOLVER, //Moves joint positions instead; see fabrik.h
+    CCD_SOLVER, //One joint at a time; see ccd.h
+    HYBRID_SOLVER //Switches between the others; see HybridPolicy
+};
+
+//Scratch storage for the dynamically sized solver path, sized once per chain
+//so that steady-state iterations never touch the heap
+struct SolverWorkspace
+{
+    Eigen::MatrixXf jacobian;
+    Eigen::VectorXf deltaTheta;
+    Eigen::JacobiSVD<Eigen::MatrixXf> svd;
+
+    void resize(int numOfConstraints);
+};
+
+//The solvers below are templates so that the dynamic path and the fixed-size
+//kernels share one implementation. None of them allocates: with fixed-size
+//arguments everything stays on the stack, and with dynamic arguments they
+//only write into storage the caller has already sized.
+
+//Scales w down so that no entry exceeds limit in magnitude
+template <class Vector>
+void clampMaxAbs(Vector& w, float limit)
+{
+    float largest = w.cwiseAbs().maxCoeff();
+    if (largest > limit)
+        w *= limit / largest;
+}
+
+//Minimum-norm solution of J * deltaTheta = deltaP, given the SVD of J with U
+//and V computed. Applied by hand rather than through JacobiSVD::solve, whose
+//temporary is heap allocated for dynamic matrices.
+template <class SVD, class Step>
+void solvePseudoInverse(const SVD& svd, const Eigen::Vector3f& deltaP, Step& deltaTheta)
+{
+    const typename SVD::SingularValuesType& sigma = svd.singularValues();
+    float threshold = sigma.size() ? sigma(0) * SINGULAR_EPSILON : 0;
+
+    deltaTheta.setZero();
+    for (int i = 0; i < sigma.size(); ++i) {
+        if (sigma(i) > threshold)
+            deltaTheta += svd.matrixV().col(i) * (svd.matrixU().col(i).dot(deltaP) / sigma(i));
+    }
+}
+
+//Minimum-norm solution of J * deltaTheta = deltaP without an SVD of J:
+//deltaTheta = J^T (J J^T)^+ deltaP. The task is always 3D, so only the 3x3
+//J J^T is factored, at a cost independent of the number of joints. Its
+//eigenvalues are the squared singular values of J, so it is formed and
+//factored in double precision to drop the same directions as the SVD path.
+//A pivoted LDLT handles the usual well-conditioned case; close to a
+//singularity the eigendecomposition decides which directions are dropped.
+template <class Jacobian, class Step>
+void solveMinimumNorm(const Jacobian& jacobian, const Eigen::Vector3f& deltaP, Step& deltaTheta)
+{
+    Eigen::Matrix3d system = Eigen::Matrix3d::Zero();
+    for (int j = 0; j < jacobian.cols(); ++j) {
+        Eigen::Vector3d column = jacobian.col(j).template cast<double>();
+        system.noalias() += column * column.transpose();
+    }
+
+    Eigen::Vector3d projected;
+    Eigen::LDLT<Eigen::Matrix3d> ldlt(system);
+    const Eigen::Vector3d& pivots = ldlt.vectorD();
+    if (pivots.minCoeff() > pivots.maxCoeff() * SINGULAR_EPSILON) {
+        projected = ldlt.solve(deltaP.cast<double>());
+    } else {
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigen(system);
+        const Eigen::Vector3d& lambda = eigen.eigenvalues(); //Increasing
+        const Eigen::Matrix3d& vectors = eigen.eigenvectors();
+        double threshold = lambda(2) * SINGULAR_EPSILON * SINGULAR_EPSILON;
+
+        projected.setZero();
+        for (int i = 0; i < 3; ++i) {
+            if (lambda(i) > threshold)
+                projected += vectors.col(i) * (vectors.col(i).dot(deltaP.cast<double>()) / lambda(i));
+        }
+    }
+    deltaTheta.noalias() = jacobian.transpose() * projected.cast<float>();
+}
+
+//Damped least squares: deltaTheta = J^T (J J^T + lambda^2 I)^-1 deltaP.
+//Only the 3x3 system is factored, whatever the number of joints.
+template <class Jacobian, class Step>
+void solveDamped(const Jacobian& jacobian, const Eigen::Vector3f& deltaP, float lambda,
+                 Step& deltaTheta)
+{
+    Eigen::Matrix3f system;
+    system.noalias() = jacobian * jacobian.transpose();
+    system.diagonal().array() += lambda * lambda;
+
+    Eigen::Vector3f projected = system.llt().solve(deltaP);
+    deltaTheta.noalias() = jacobian.transpose() * projected;
+}
+
+//Selectively damped least squares (Buss and Kim): each singular vector's
+//contribution is clamped according to how far it would actually move the end
+//effector, and the total step is clamped to maxStep per joint parameter.
+//svd must hold the decomposition of jacobian.
+template <class Jacobian, class SVD, class Step>
+void solveSelectivelyDamped(const Jacobian& jacobian, const SVD& svd,
+                            const Eigen::Vector3f& deltaP, float maxStep,
+                            Step& deltaTheta)
+{
+    const typename SVD::SingularValuesType& sigma = svd.singularValues();
+
+    deltaTheta.setZero();
+
+    for (int i = 0; i < sigma.size(); ++i) {
+        if (sigma(i) < SINGULAR_EPSILON)
+            break;
+
+        float alpha = svd.matrixU().col(i).dot(deltaP);
+
+        //How far the end effector moves along this singular vector; with a
+        //single end effector N_i = |u_i| = 1
+        float m = 0;
+        for (int j = 0; j < jacobian.cols(); ++j)
+            m += std::abs(svd.matrixV()(j, i)) * jacobian.col(j).norm();
+        m /= sigma(i);
+        float gamma = std::min(1.0f, 1.0f / m) * maxStep;
+
+        float scale = alpha / sigma(i);
+        float largest = svd.matrixV().col(i).cwiseAbs().maxCoeff() * std::abs(scale);
+        if (largest > gamma)
+            scale *= gamma / largest;
+        deltaTheta += svd.matrixV().col(i) * scale;
+    }
+
+    clampMaxAbs(deltaTheta, maxStep);
+}
+
+//Broyden's rank-one correction of a Jacobian from an observed step: after
+//it, J * deltaTheta = deltaX, and J is unchanged in every direction
+//orthogonal to deltaTheta. Costs one pass over the columns instead of a
+//rebuild from the joints.
+template <class Jacobian>
+void updateBroyden(Jacobian& jacobian, const Eigen::Vector3f& deltaX, const float* deltaTheta)
+{
+    float norm = 0;
+    Eigen::Vector3f residual = deltaX;
+    for (int j = 0; j < jacobian.cols(); ++j) {
+        norm += deltaTheta[j] * deltaTheta[j];
+        residual -= jacobian.col(j) * deltaTheta[j];
+    }
+    if (norm <= 0)
+        return;
+
+    residual /= norm;
+    for (int j = 0; j < jacobian.cols(); ++j)
+        jacobian.col(j) += residual * deltaTheta[j];
+}
+
+#endif
@@ -0,0 +1,102 @@
+#include <cmath>
+
+#include "telemetry.h"
+
+void
+SolveTelemetry::reset(void)
+{
+    iterations = 0;
+    halvings = 0;
+    rejectedSteps = 0;
+    fkEvaluations = 0;
+    converged = false;
+    initialError = 0;
+    finalError = 0;
+    fkSeconds = 0;
+    jacobianSeconds = 0;
+    stepSeconds = 0;
+    totalSeconds = 0;
+    strengths.clear();
+    errors.clear();
+    strengths.reserve(MAX_HISTORY);
+    errors.reserve(MAX_HISTORY);
+}
+
+bool
+TelemetryLog::open(const char* path, TelemetryFormat format)
+{
+    close();
+    m_pFile = fopen(path, "w");
+    m_format = format;
+    if (!m_pFile)
+        return false;
+
+    if (m_format == CSV_TELEMETRY)
+        fprintf(m_pFile, "frame,iterations,halvings,rejected_steps,fk_evaluations,converged,initial_error,"
+                         "final_error,fk_us,jacobian_us,step_us,total_us,strengths,errors\n");
+    return true;
+}
+
+void
+TelemetryLog::close(void)
+{
+    if (m_pFile)
+        fclose(m_pFile);
+    m_pFile = NULL;
+}
+
+//JSON has no nan or inf, so a diverged solve's values are written as null
+static void
+writeValue(FILE* file, float value, bool json)
+{
+    if (json && !std::isfinite(value))
+        fprintf(file, "null");
+    else
+        fprintf(file, "%g", value);
+}
+
+//Writes values separated by separator
+static void
+writeList(FILE* file, const std::vector<float>& values, const char* separator, bool json)
+{
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i)
+            fprintf(file, "%s", separator);
+        writeValue(file, values[i], json);
+    }
+}
+
+void
+TelemetryLog::write(int frame, const SolveTelemetry& t)
+{
+    if (!m_pFile)
+        return;
+
+    if (m_format == CSV_TELEMETRY) {
+        fprintf(m_pFile, "%d,%d,%d,%d,%d,%d,%g,%g,%.2f,%.2f,%.2f,%.2f,", frame, t.iterations,
+                t.halvings, t.rejectedSteps, t.fkEvaluations, t.converged, t.initialError,
+                t.finalError, t.fkSeconds * 1e6, t.jacobianSeconds * 1e6, t.stepSeconds * 1e6,
+                t.totalSeconds * 1e6);
+        writeList(m_pFile, t.strengths, ";", false);
+        fprintf(m_pFile, ",");
+        writeList(m_pFile, t.errors, ";", false);
+        fprintf(m_pFile, "\n");
+    } else {
+        fprintf(m_pFile, "{\"frame\": %d, \"iterations\": %d, \"halvings\": %d, "
+                         "\"rejected_steps\": %d, \"fk_evaluations\": %d, \"converged\": %s, "
+                         "\"initial_error\": ",
+                frame, t.iterations, t.halvings, t.rejectedSteps, t.fkEvaluations,
+                t.converged ? "true" : "false");
+        writeValue(m_pFile, t.initialError, true);
+        fprintf(m_pFile, ", \"final_error\": ");
+        writeValue(m_pFile, t.finalError, true);
+        fprintf(m_pFile, ", \"fk_us\": %.2f, \"jacobian_us\": %.2f, \"step_us\": %.2f, "
+                         "\"total_us\": %.2f, \"strengths\": [",
+                t.fkSeconds * 1e6, t.jacobianSeconds * 1e6, t.stepSeconds * 1e6,
+                t.totalSeconds * 1e6);
+        writeList(m_pFile, t.strengths, ", ", true);
+        fprintf(m_pFile, "], \"errors\": [");
+        writeList(m_pFile, t.errors, ", ", true);
+        fprintf(m_pFile, "]}\n");
+    }
+}
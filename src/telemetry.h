@@ -0,0 +1,109 @@
+#ifndef __incl_telemetry__
+#define __incl_telemetry__
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+//What one ChainSolver::solve call did and where its time went. fk covers
+//end effector evaluations, jacobian the kernel's Jacobian update (which
+//refreshes the frames it needs), and step the SVD or factorization, the step
+//and applying it. The histories hold one entry per iteration, up to
+//MAX_HISTORY; their storage is reserved once so that recording never
+//allocates during a solve.
+struct SolveTelemetry
+{
+    enum { MAX_HISTORY = 1024 };
+
+    int iterations;
+    int halvings; //Line search backtracks, and strength halvings after the error grew
+    int rejectedSteps; //DLS steps rolled back for stiffer damping
+    int fkEvaluations; //End effector evaluations, trial poses included
+    bool converged;
+    float initialError;
+    float finalError;
+
+    double fkSeconds;
+    double jacobianSeconds;
+    double stepSeconds;
+    double totalSeconds;
+
+    std::vector<float> strengths;
+    std::vector<float> errors;
+
+    SolveTelemetry(void) {
+        reset();
+    }
+
+    //Clears the counters, keeping the histories' storage
+    void reset(void);
+
+    //Appends one iteration to the histories unless they are full
+    void record(float strength, float error) {
+        if (errors.size() < MAX_HISTORY) {
+            strengths.push_back(strength);
+            errors.push_back(error);
+        }
+    }
+};
+
+//Adds the time from construction to destruction to *seconds; does nothing
+//when seconds is NULL, so disabled telemetry costs one branch
+class ScopedTimer
+{
+    double* m_pSeconds;
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    explicit ScopedTimer(double* seconds)
+    {
+        m_pSeconds = seconds;
+        if (m_pSeconds)
+            m_start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedTimer(void)
+    {
+        if (m_pSeconds)
+            *m_pSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                         m_start).count();
+    }
+};
+
+enum TelemetryFormat
+{
+    CSV_TELEMETRY,
+    JSON_TELEMETRY
+};
+
+//Appends one record per frame to a file: CSV with a header row, or one JSON
+//object per line
+class TelemetryLog
+{
+    FILE* m_pFile;
+    TelemetryFormat m_format;
+
+    TelemetryLog(const TelemetryLog&);
+    TelemetryLog& operator=(const TelemetryLog&);
+
+public:
+    TelemetryLog(void) {
+        m_pFile = NULL;
+        m_format = CSV_TELEMETRY;
+    }
+
+    ~TelemetryLog(void) {
+        close();
+    }
+
+    bool open(const char* path, TelemetryFormat format);
+    void close(void);
+
+    bool isOpen(void) const {
+        return m_pFile != NULL;
+    }
+
+    void write(int frame, const SolveTelemetry& telemetry);
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include <algorithm>
+
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(int numOfThreads)
+{
+    if (numOfThreads <= 0)
+        numOfThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    m_generation = 0;
+    m_pending = 0;
+    m_stopping = false;
+
+    for (int i = 0; i < numOfThreads; ++i)
+        m_queues.push_back(new Queue());
+    for (int i = 0; i < numOfThreads; ++i)
+        m_threads.push_back(std::thread(&ThreadPool::work, this, i));
+}
+
+ThreadPool::~ThreadPool(void)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (size_t i = 0; i < m_threads.size(); ++i)
+        m_threads[i].join();
+    for (size_t i = 0; i < m_queues.size(); ++i)
+        delete m_queues[i];
+}
+
+bool
+ThreadPool::takeRange(int worker, Range& range)
+{
+    Queue* own = m_queues[worker];
+    {
+        std::lock_guard<std::mutex> guard(own->lock);
+        if (!own->ranges.empty()) {
+            range = own->ranges.back();
+            own->ranges.pop_back();
+            return true;
+        }
+    }
+
+    int numOfQueues = m_queues.size();
+    for (int i = 1; i < numOfQueues; ++i) {
+        Queue* victim = m_queues[(worker + i) % numOfQueues];
+        std::lock_guard<std::mutex> guard(victim->lock);
+        if (!victim->ranges.empty()) {
+            range = victim->ranges.front();
+            victim->ranges.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+ThreadPool::work(int worker)
+{
+    int seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> guard(m_lock);
+            while (!m_stopping && m_generation == seen)
+                m_wake.wait(guard);
+            if (m_stopping)
+                return;
+            seen = m_generation;
+        }
+
+        //A worker still draining the previous loop may pick up ranges of
+        //the next one, which is why every range carries its own task
+        Range range;
+        while (takeRange(worker, range)) {
+            (*range.task)(range.begin, range.end, worker);
+
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (--m_pending == 0)
+                m_done.notify_all();
+        }
+    }
+}
+
+void
+ThreadPool::parallelFor(int count, int grain, const Task& task)
+{
+    if (count <= 0)
+        return;
+    if (grain < 1)
+        grain = 1;
+
+    std::unique_lock<std::mutex> guard(m_lock);
+    m_pending = (count + grain - 1) / grain;
+
+    //Deal the ranges out round-robin; stealing evens out whatever is left
+    int numOfRanges = 0;
+    for (int begin = 0; begin < count; begin += grain, ++numOfRanges) {
+        Range range = { begin, std::min(begin + grain, count), &task };
+        Queue* queue = m_queues[numOfRanges % m_queues.size()];
+        std::lock_guard<std::mutex> queueGuard(queue->lock);
+        queue->ranges.push_back(range);
+    }
+
+    ++m_generation;
+    m_wake.notify_all();
+
+    while (m_pending > 0)
+        m_done.wait(guard);
+}
@@ -0,0 +1,67 @@
+#ifndef __incl_threadpool__
+#define __incl_threadpool__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed set of worker threads for data-parallel loops. Each worker owns a
+//queue of index ranges; it takes work from the back of its own queue and,
+//when that runs dry, steals from the front of the others', so uneven ranges
+//(targets that take many more iterations than their neighbours) balance out
+//without a shared queue becoming a point of contention.
+class ThreadPool
+{
+public:
+    //Called with a half-open range [begin, end) and the index of the worker
+    //running it, which is stable for the pool's lifetime
+    typedef std::function<void(int begin, int end, int worker)> Task;
+
+private:
+    struct Range
+    {
+        int begin;
+        int end;
+        const Task* task;
+    };
+
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<Range> ranges;
+    };
+
+    std::vector<std::thread> m_threads;
+    std::vector<Queue*> m_queues;
+
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    int m_generation;
+    int m_pending; //Ranges not yet finished in the current loop
+    bool m_stopping;
+
+    bool takeRange(int worker, Range& range);
+    void work(int worker);
+
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+public:
+    //Zero threads means one per hardware thread
+    explicit ThreadPool(int numOfThreads = 0);
+    ~ThreadPool(void);
+
+    int getNumOfThreads(void) const {
+        return m_threads.size();
+    }
+
+    //Runs task over [0, count) in ranges of at most grain indices and
+    //returns once every range is done. Not reentrant.
+    void parallelFor(int count, int grain, const Task& task);
+};
+
+#endif
@@ -0,0 +1,25 @@
+#include "tracker.h"
+
+PathTracker::PathTracker(ChainSolver* solver, bool warmStart, float stepDegrees)
+{
+    m_pSolver = solver;
+    m_warmStart = warmStart;
+    m_stepDegrees = stepDegrees;
+    m_predictor.reset(solver->getChain().getNumOfConstraints());
+}
+
+SolveResult
+PathTracker::update(Path& path)
+{
+    Eigen::Vector3f goalPoint = path.getNextPoint(m_stepDegrees);
+
+    //The goal moves by the same step every update, so the joints roughly
+    //keep the velocity they had over the last one
+    const float* guess = m_warmStart ? m_predictor.predict() : NULL;
+    if (guess)
+        m_pSolver->warmStart(goalPoint, guess);
+
+    SolveResult result = m_pSolver->solve(goalPoint);
+    m_predictor.record(m_pSolver->getChain().getParams());
+    return result;
+}
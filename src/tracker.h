@@ -0,0 +1,25 @@
+#ifndef __incl_tracker__
+#define __incl_tracker__
+
+#include "chainsolver.h"
+#include "path.h"
+#include "predictor.h"
+
+//Follows a path with one solver, one path step per update. With warm start
+//on, each solve begins from the pose extrapolated from the last two
+//solutions when that lands closer to the new goal.
+class PathTracker
+{
+    ChainSolver* m_pSolver;
+    PosePredictor m_predictor;
+    bool m_warmStart;
+    float m_stepDegrees;
+
+public:
+    PathTracker(ChainSolver* solver, bool warmStart, float stepDegrees = 1.5f);
+
+    //Advances path by one step and solves for its new point
+    SolveResult update(Path& path);
+};
+
+#endif
@@ -0,0 +1,297 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include <algorithm>
+#include <thread>
+
+#ifdef __APPLE__
+#include <GLUT/glut.h>
+#include <OpenGL/gl.h>
+#include <OpenGL/glu.h>
+#else
+#include <GL/glut.h>
+#include <GL/glu.h>
+#endif
+
+#include "viewer.h"
+#include "assert.h"
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#define DEFAULT_WIDTH 720
+#define DEFAULT_HEIGHT 720
+#define LOOKAHEAD_WAIT 0.001 //Seconds between polls for a due look-ahead frame
+
+//---------------Scene Rendering---------------
+
+static void
+renderJoint(int type, const float* state)
+{
+    GLUquadric* quad;
+    switch (type) {
+        case BALL_JOINT:
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            quad = gluNewQuadric();
+            gluSphere(quad, 0.03, 10, 10);
+            break;
+        case PIN_JOINT:
+            glPushMatrix();
+            glTranslatef(0, 0, -0.04);
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            quad = gluNewQuadric();
+            gluCylinder(quad, 0.02, 0.02, 0.08, 10, 10);
+
+            gluDisk(quad, 0, 0.02, 10, 10);
+            glTranslatef(0, 0, 0.08);
+            gluDisk(quad, 0, 0.02, 10, 10);
+
+            glPopMatrix();
+            break;
+        case PRISM_JOINT:
+            glPushMatrix();
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            glRotatef(90, 0, 1, 0);
+            glTranslatef(0, 0, -state[0]);
+            quad = gluNewQuadric();
+            gluCylinder(quad, 0.03, 0.03, state[0], 10, 10);
+            glPopMatrix();
+            break;
+        case DOUBLE_PIN_JOINT:
+            glPushMatrix();
+            glTranslatef(0, 0, -0.04);
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            quad = gluNewQuadric();
+            gluCylinder(quad, 0.02, 0.02, 0.08, 10, 10);
+
+            gluDisk(quad, 0, 0.02, 10, 10);
+            glTranslatef(0, 0, 0.08);
+            gluDisk(quad, 0, 0.02, 10, 10);
+            glPopMatrix();
+
+            glPushMatrix();
+            glRotatef(90, 1, 0, 0);
+            glTranslatef(0, 0, -0.04);
+            gluCylinder(quad, 0.02, 0.02, 0.08, 10, 10);
+
+            gluDisk(quad, 0, 0.02, 10, 10);
+            glTranslatef(0, 0, 0.08);
+            gluDisk(quad, 0, 0.02, 10, 10);
+            glPopMatrix();
+            break;
+    }
+}
+
+static void
+renderArm(const Chain& chain)
+{
+    glPushMatrix();
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    for (int i = 0; i < chain.getNumOfJoints(); ++i) {
+        Eigen::Matrix4f transform = chain.getTransform(i);
+        GLfloat vals[16];
+        for (int col = 0; col < transform.cols(); col++) {
+            for (int row = 0; row < transform.rows(); row++) {
+                vals[col * 4 + row] = transform(row, col);
+            }
+        }
+
+        glMultMatrixf(vals);
+
+        //Draw joint and body here
+        glPushMatrix();
+        glRotatef(90, 0, 1, 0);
+        glutSolidCone(0.03, chain.getLength(i), 32, 32);
+        glPopMatrix();
+        renderJoint(chain.getType(i), chain.getParams() + chain.getOffset(i));
+
+        glTranslatef(chain.getLength(i), 0.0, 0.0);
+    }
+    glPopMatrix();
+}
+
+static void
+renderPath(Path& path)
+{
+	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	glBegin(GL_POLYGON);
+	for (int i = 0; i < 360; i++) {
+		Eigen::Vector3f curr = path.getCurrPoint();
+		glVertex3f(curr(0), curr(1), curr(2));
+		path.addDegree(1);
+	}
+	glEnd();
+
+	//Draw ball at current point
+	glPushMatrix();
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	Eigen::Vector3f currPoint = path.getCurrPoint();
+	glTranslatef(currPoint(0), currPoint(1), currPoint(2));
+	GLUquadric* quad = gluNewQuadric();
+	gluSphere(quad, 0.05, 10, 10);
+	glPopMatrix();
+}
+
+//---------------Viewer---------------
+
+void
+Viewer::init(int argc, char** argv, FILE* input)
+{
+    Root::init(argc, argv, input);
+
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGB);
+    glutInitWindowSize(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+    glutInitWindowPosition(0,0);
+    return;
+}
+
+void
+Viewer::run(void (*render)(void),
+          void (*reshape)(int, int),
+          void (*idle)(void),
+          void (*input)(unsigned char, int, int)) {
+    assert(m_isInitialized);
+    m_pArm->print();
+    m_pArmPath->print();
+
+    glutCreateWindow("root");
+    glutDisplayFunc(render);
+    glutReshapeFunc(reshape);
+    glutIdleFunc(idle);
+    glutKeyboardFunc(input);
+
+    glMatrixMode(GL_MODELVIEW);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    glLoadIdentity();
+
+    glDepthFunc(GL_LEQUAL);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_NORMALIZE);
+
+    glOrtho(-m_maxSize, m_maxSize, -m_maxSize, m_maxSize, m_maxSize, -m_maxSize);
+
+    //Lighting
+    GLfloat position0[] = {5.0, 5.0, 0.0, 1.0};
+    GLfloat ambient0[] = {0.5, 1.0, 1.0, 1.0};
+    GLfloat diffuse0[] = {1.0, 0.1, 0.3, 1.0};
+    GLfloat specular0[] = {0.1, 0.1, 0.1, 1.0};
+    glLightfv(GL_LIGHT0, GL_POSITION, position0);
+    glLightfv(GL_LIGHT0, GL_AMBIENT, ambient0);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse0);
+    glLightfv(GL_LIGHT0, GL_SPECULAR, specular0);
+
+    //Lighting
+    GLfloat position1[] = {-5.0, -5.0, 0.0, 1.0};
+    GLfloat ambient1[] = {0.0, 0.0, 0.3, 1.0};
+    GLfloat diffuse1[] = {0.05, 0.2, 0.8, 1.0};
+    GLfloat specular1[] = {0.05, 0.1, 0.1, 1.0};
+    glLightfv(GL_LIGHT1, GL_POSITION, position1);
+    glLightfv(GL_LIGHT1, GL_AMBIENT, ambient1);
+    glLightfv(GL_LIGHT1, GL_DIFFUSE, diffuse1);
+    glLightfv(GL_LIGHT1, GL_SPECULAR, specular1);
+
+    GLfloat position2[] = {-5.0, 0.0, 0.0, 1.0};
+    GLfloat ambient2[] = {0.0, 0.3, 0.0, 1.0};
+    GLfloat diffuse2[] = {0.05, 0.8, 0.2, 1.0};
+    GLfloat specular2[] = {0.1, 0.2, 0.1, 1.0};
+    glLightfv(GL_LIGHT2, GL_POSITION, position2);
+    glLightfv(GL_LIGHT2, GL_AMBIENT, ambient2);
+    glLightfv(GL_LIGHT2, GL_DIFFUSE, diffuse2);
+    glLightfv(GL_LIGHT2, GL_SPECULAR, specular2);
+
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glEnable(GL_LIGHT1);
+    glEnable(GL_LIGHT2);
+
+    m_renderChain = m_pArm->getChain();
+    m_scheduler.setRates(m_updateRate, m_renderRate);
+    m_scheduler.start();
+
+    glColor3f(rand()/(float)RAND_MAX, rand()/(float)RAND_MAX, rand()/(float)RAND_MAX);
+    glutMainLoop();
+}
+
+void
+Viewer::render(float interpolation)
+{
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    //Only the published snapshot is read, never the arm or path being solved
+    const PoseSnapshot& pose = getLatestPose();
+    m_renderPath = pose.path;
+    pose.interpolate(m_renderChain, interpolation, m_renderParams);
+    m_renderChain.setParams(&m_renderParams[0]);
+
+    glPushMatrix();
+    glTranslatef(0, -0.5, 0);
+    glRotatef(90, 1, 0, 0);
+    glRotatef(pose.getDegree(interpolation), 0, 0, -1);
+    renderPath(m_renderPath);
+    renderArm(m_renderChain);
+    glPopMatrix();
+
+    glFlush();
+    glutSwapBuffers();
+    return;
+}
+
+//---------------OpenGL Helper Functions---------------
+
+void
+Viewer::handleInput(unsigned char key, int x, int y) {
+    switch (key) {
+        case ' ':
+            halt();
+            exit(EXIT_SUCCESS);
+            break;
+        default:
+            break;
+    }
+    return;
+}
+
+void
+Viewer::render() { //OpenGL glDisplayFunc
+    return;
+}
+
+void
+Viewer::idle() {
+    m_scheduler.tick();
+
+    //Catch up on every update that is due. A look-ahead frame that is not
+    //ready yet stays due and is picked up on a later idle.
+    SolveResult result;
+    bool waiting = false;
+    while (m_scheduler.isUpdateDue()) {
+        if (!poll(result)) {
+            waiting = true;
+            break;
+        }
+        m_scheduler.consumeUpdate();
+    }
+
+    if (m_scheduler.takeRender()) {
+        render(m_scheduler.getInterpolation());
+    } else {
+        //An update still due leaves no idle time; wait for its frame briefly
+        //rather than spin, without sleeping past the next render
+        double idle = waiting ? std::min(m_scheduler.getRenderIdleTime(), LOOKAHEAD_WAIT) :
+                                m_scheduler.getIdleTime();
+        std::this_thread::sleep_for(std::chrono::duration<double>(idle));
+    }
+
+    return;
+}
+
+void
+Viewer::reshape(int width, int height) {
+    glViewport(0, 0, width, height);
+    return;
+}
@@ -0,0 +1,34 @@
+#ifndef __incl_viewer__
+#define __incl_viewer__
+
+#include "root.h"
+#include "scheduler.h"
+
+//GLUT window around a Root: draws the path and the arm and runs update()
+//from the idle callback at the scene's fixed update rate, drawing the pose
+//interpolated between updates. All OpenGL and GLUT code lives in
+//viewer.cpp, so everything else builds and links without them.
+class Viewer : public Root
+{
+    FixedStepScheduler m_scheduler;
+    Chain m_renderChain; //Holds the interpolated pose being drawn
+    std::vector<float> m_renderParams;
+    Path m_renderPath; //renderPath walks it around and back
+
+public:
+    virtual void init(int argc, char** argv, FILE* input);
+
+    virtual void run(void (*render)(void),
+          void (*reshape)(int, int),
+          void (*idle)(void),
+          void (*input)(unsigned char, int, int));
+    virtual void render(float interpolation);
+
+    //OpenGL helper functions
+    virtual void handleInput(unsigned char key, int x, int y);
+    virtual void reshape(int width, int height);
+    virtual void idle();
+    virtual void render();
+};
+
+#endif